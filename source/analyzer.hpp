@@ -4,6 +4,7 @@
 #include "ast.h"
 #include <unordered_map>
 #include <string>
+#include <algorithm>
 #include <limits>
 #include <unordered_set>
 
@@ -22,6 +23,11 @@ const string DREF_FUNCTION = "@dref";
 const string SREF_FUNCTION = "@sref";
 const unordered_set<string> SKIP_IDENT_NAMES = {"@HP", "@FREE"};
 
+//optimizer variables '*p' stand for the memory p points to
+inline bool isMemoryAlias(const string& name) {
+    return !name.empty() && name[0] == '*';
+}
+
 struct FunctionDescr {
     string name;
     Type type; //type
@@ -29,6 +35,18 @@ struct FunctionDescr {
     string address;
 };
 
+//calling convention: arguments in R0.., main and functions with more parameters pass them on the stack; the result is in R0
+const int MAX_REGISTER_ARGUMENTS = 6;
+
+inline bool usesRegisterArguments(const FunctionDescr& descr) {
+    return descr.name != "main" && descr.params.size() <= MAX_REGISTER_ARGUMENTS;
+}
+
+//number of registers from R0 on that a call does not preserve
+inline int getClobberedRegisters(const FunctionDescr& descr) {
+    return max(usesRegisterArguments(descr) ? static_cast<int>(descr.params.size()) : 0, descr.type.size() != 0 ? 1 : 0);
+}
+
 pair<vector<FunctionDescr>,unordered_map<string,unordered_map<string,Type>>> analyze(vector<shared_ptr<ASTNode>>& nodes);
 void checkFunctionNames(const vector<FunctionDescr>& function_descrs);
 bool checkSameFunction(FunctionDescr,FunctionDescr);
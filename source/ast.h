@@ -15,8 +15,23 @@ class ASTNode {
 public:
     virtual ~ASTNode() = default;
     virtual void print(int indent = 0) const = 0;
+    // tiefe Kopie des Teilbaums
+    virtual shared_ptr<ASTNode> clone() const = 0;
 };
 
+static vector<shared_ptr<ASTNode>> cloneNodes(const vector<shared_ptr<ASTNode>>& nodes) {
+    vector<shared_ptr<ASTNode>> copy;
+    copy.reserve(nodes.size());
+    for (const auto& node : nodes) {
+        copy.push_back(node ? node->clone() : nullptr);
+    }
+    return copy;
+}
+
+static shared_ptr<ASTNode> cloneNode(const shared_ptr<ASTNode>& node) {
+    return node ? node->clone() : nullptr;
+}
+
 // AST-Knoten für Zahlen
 class NumberNode : public ASTNode {
 public:
@@ -27,6 +42,10 @@ public:
     void print(int indent = 0) const override {
         cout << string(indent, ' ') << "Number(" << value << ")\n";
     }
+
+    shared_ptr<ASTNode> clone() const override {
+        return make_shared<NumberNode>(value);
+    }
 };
 
 // AST-Knoten für Variablen (Identifier), wenn size != -1 dann Array Indizierung
@@ -49,6 +68,10 @@ public:
             cout << string(indent, ' ') << "]\n";
         }
     }
+
+    shared_ptr<ASTNode> clone() const override {
+        return make_shared<IdentifierNode>(name, cloneNode(index));
+    }
 };
 
 // AST-Knoten für Zuweisungen (e.g. `x = 5;`)
@@ -65,6 +88,10 @@ public:
         variable->print(indent + 2);
         expression->print(indent + 2);
     }
+
+    shared_ptr<ASTNode> clone() const override {
+        return make_shared<AssignmentNode>(static_pointer_cast<IdentifierNode>(variable->clone()), cloneNode(expression));
+    }
 };
 
 // AST-Knoten für Funktionsaufrufe (e.g. `myFunction(5, x);`)
@@ -72,6 +99,7 @@ class FunctionCallNode : public ASTNode {
 public:
     string functionName;
     vector<shared_ptr<ASTNode>> arguments;
+    bool isTailCall = false; // reuses the frame of the caller, set by the optimizer
 
     explicit FunctionCallNode(string name) : functionName(move(name)) {}
 
@@ -81,6 +109,13 @@ public:
             arg->print(indent + 2);
         }
     }
+
+    shared_ptr<ASTNode> clone() const override {
+        auto copy = make_shared<FunctionCallNode>(functionName);
+        copy->arguments = cloneNodes(arguments);
+        copy->isTailCall = isTailCall;
+        return copy;
+    }
 };
 
 // AST-Knoten für return
@@ -91,6 +126,10 @@ public:
     void print(int indent = 0) const override {
         cout << string(indent, ' ') << "Return\n";
     }
+
+    shared_ptr<ASTNode> clone() const override {
+        return make_shared<ReturnNode>();
+    }
 };
 
 // AST-Knoten für return
@@ -104,6 +143,10 @@ public:
         cout << string(indent, ' ') << "ReturnValue\n";
         value->print(indent + 2);
     }
+
+    shared_ptr<ASTNode> clone() const override {
+        return make_shared<ReturnValueNode>(cloneNode(value));
+    }
 };
 
 class FunctionDefinitionNode : public ASTNode {
@@ -112,6 +155,7 @@ public:
     string functionName;
     vector<pair<Type, string>> parameters;
     vector<shared_ptr<ASTNode>> body;
+    bool isInline = false; // 'inline' hint for the optimizer
 
     FunctionDefinitionNode(Type rType, string fName,
                            vector<pair<Type, string>> params,
@@ -125,6 +169,12 @@ public:
             stmt->print(indent + 2);
         }
     }
+
+    shared_ptr<ASTNode> clone() const override {
+        auto copy = make_shared<FunctionDefinitionNode>(returnType, functionName, parameters, cloneNodes(body));
+        copy->isInline = isInline;
+        return copy;
+    }
 };
 
 class VariableDeclarationNode : public ASTNode {
@@ -140,6 +190,10 @@ public:
         cout << string(indent, ' ') << "VariableDeclaration(" << varType.toString() << " " << varName << ")\n";
         value->print(indent + 2);
     }
+
+    shared_ptr<ASTNode> clone() const override {
+        return make_shared<VariableDeclarationNode>(varType, varName, cloneNode(value));
+    }
 };
 
 // AST Node for `if` statements
@@ -172,6 +226,10 @@ public:
             }
         }
     }
+
+    std::shared_ptr<ASTNode> clone() const override {
+        return std::make_shared<IfNode>(cloneNode(condition), cloneNodes(thenBlock), cloneNodes(elseBlock));
+    }
 };
 
 // Enum for logical operators
@@ -203,6 +261,10 @@ public:
         right->print(indent + 2);
     }
 
+    std::shared_ptr<ASTNode> clone() const override {
+        return std::make_shared<LogicalNode>(logicalType, cloneNode(left), cloneNode(right));
+    }
+
 private:
     std::string getLogicalOperator() const {
         switch (logicalType) {
@@ -231,6 +293,10 @@ public:
         std::cout << std::string(indent, ' ') << "LogicalNotExpression(!)\n";
         operand->print(indent + 2);
     }
+
+    std::shared_ptr<ASTNode> clone() const override {
+        return std::make_shared<LogicalNotNode>(cloneNode(operand));
+    }
 };
 
 // Enum for arithmetic operators
@@ -258,6 +324,10 @@ public:
         right->print(indent + 2);
     }
 
+    std::shared_ptr<ASTNode> clone() const override {
+        return std::make_shared<ArithmeticNode>(arithmeticType, cloneNode(left), cloneNode(right));
+    }
+
 private:
     std::string getOperator() const {
         switch (arithmeticType) {
@@ -293,6 +363,10 @@ public:
             cout << std::string(indent + 2, ' ') << "Empty("<< size <<")\n";
         }
     }
+
+    std::shared_ptr<ASTNode> clone() const override {
+        return std::make_shared<ArrayDeclarationNode>(type, size, cloneNodes(arrayValues), name);
+    }
 };
 
 // AST Node for Goto Statement
@@ -303,6 +377,10 @@ public:
     void print(int indent = 0) const override {
         std::cout << std::string(indent, ' ') << "Goto(" << label << ")\n";
     }
+
+    std::shared_ptr<ASTNode> clone() const override {
+        return std::make_shared<GotoNode>(label);
+    }
 };
 
 class LabelNode : public ASTNode {
@@ -314,22 +392,50 @@ public:
     void print(int indent = 0) const override {
         std::cout << std::string(indent, ' ') << "Label(" << label << ")\n";
     }
+
+    std::shared_ptr<ASTNode> clone() const override {
+        return std::make_shared<LabelNode>(label);
+    }
 };
 
+static void printPreheader(int indent, const shared_ptr<ASTNode>& guard, const vector<shared_ptr<ASTNode>>& preheader) {
+    if (guard) {
+        std::cout << std::string(indent + 2, ' ') << "Guard\n";
+        guard->print(indent + 4);
+    }
+    if (!preheader.empty()) {
+        std::cout << std::string(indent + 2, ' ') << "Preheader\n";
+        for (const auto &stmt : preheader) {
+            stmt->print(indent + 4);
+        }
+    }
+}
+
 // AST Node for While Loop
 class WhileNode : public ASTNode {
 public:
     std::shared_ptr<ASTNode> condition;
     std::vector<std::shared_ptr<ASTNode>> body;
+    // filled by the optimizer: runs once after the entry test (guard, defaults to condition)
+    std::vector<std::shared_ptr<ASTNode>> preheader;
+    std::shared_ptr<ASTNode> guard;
     WhileNode(std::shared_ptr<ASTNode> cond, std::vector<std::shared_ptr<ASTNode>> b)
         : condition(std::move(cond)), body(std::move(b)) {}
     void print(int indent = 0) const override {
         std::cout << std::string(indent, ' ') << "WhileLoop\n";
         condition->print(indent + 2);
+        printPreheader(indent, guard, preheader);
         for (const auto &stmt : body) {
             stmt->print(indent + 2);
         }
     }
+
+    std::shared_ptr<ASTNode> clone() const override {
+        auto copy = std::make_shared<WhileNode>(cloneNode(condition), cloneNodes(body));
+        copy->preheader = cloneNodes(preheader);
+        copy->guard = cloneNode(guard);
+        return copy;
+    }
 };
 
 // AST Node for For Loop
@@ -339,6 +445,8 @@ public:
     std::shared_ptr<ASTNode> condition;
     std::shared_ptr<ASTNode> update;
     std::vector<std::shared_ptr<ASTNode>> body;
+    std::vector<std::shared_ptr<ASTNode>> preheader;
+    std::shared_ptr<ASTNode> guard;
     ForNode(std::shared_ptr<ASTNode> i, std::shared_ptr<ASTNode> cond, std::shared_ptr<ASTNode> upd, std::vector<std::shared_ptr<ASTNode>> b)
         : init(std::move(i)), condition(std::move(cond)), update(std::move(upd)), body(std::move(b)) {}
     void print(int indent = 0) const override {
@@ -346,10 +454,18 @@ public:
         init->print(indent + 2);
         condition->print(indent + 2);
         update->print(indent + 2);
+        printPreheader(indent, guard, preheader);
         for (const auto &stmt : body) {
             stmt->print(indent + 2);
         }
     }
+
+    std::shared_ptr<ASTNode> clone() const override {
+        auto copy = std::make_shared<ForNode>(cloneNode(init), cloneNode(condition), cloneNode(update), cloneNodes(body));
+        copy->preheader = cloneNodes(preheader);
+        copy->guard = cloneNode(guard);
+        return copy;
+    }
 };
 
 // AST Node for For Loop
@@ -364,6 +480,10 @@ public:
             stmt->print(indent + 2);
         }
     }
+
+    std::shared_ptr<ASTNode> clone() const override {
+        return std::make_shared<BlockNode>(cloneNodes(body));
+    }
 };
 
 #endif // AST_H
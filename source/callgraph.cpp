@@ -0,0 +1,99 @@
+#include "callgraph.hpp"
+
+#include <algorithm>
+
+CallGraph::CallGraph(const vector<shared_ptr<ASTNode>>& ast, const vector<FunctionDescr>& function_descrs, const unordered_map<string, unordered_map<string, Type>>& variables) {
+    string mallocAddress;
+    for (const FunctionDescr& descr : function_descrs) {
+        if (descr.name == "malloc") mallocAddress = descr.address;
+    }
+
+    for (const shared_ptr<ASTNode>& node : ast) {
+        auto function = dynamic_pointer_cast<FunctionDefinitionNode>(node);
+        if (function == nullptr) {
+            continue;
+        }
+        string address = findFunctionDescr(function, function_descrs).address;
+        functions.push_back(address);
+        callers[address];
+        vector<string>& targets = callees[address];
+        auto addCall = [&](const string& callee) {
+            if (!callee.empty() && find(targets.begin(), targets.end(), callee) == targets.end()) {
+                targets.push_back(callee);
+            }
+        };
+        const unordered_map<string, Type>& function_variables = variables.at(function->functionName);
+        for (const auto& stmt : function->body) {
+            visitNodes(stmt, [&](const shared_ptr<ASTNode>& x) {
+                if (auto call = dynamic_pointer_cast<FunctionCallNode>(x)) {
+                    if (!isBuiltinFunction(call->functionName)) {
+                        addCall(findCallDescr(call, function_variables, function_descrs).address);
+                    }
+                }
+                else if (dynamic_pointer_cast<ArrayDeclarationNode>(x)) {
+                    addCall(mallocAddress);
+                }
+            });
+        }
+    }
+    for (const string& address : functions) {
+        for (const string& callee : callees.at(address)) {
+            callers[callee].push_back(address);
+            if (callee == address) recursive.insert(address);
+        }
+    }
+
+    for (const string& address : functions) {
+        if (!index.count(address)) findComponents(address);
+    }
+    //Tarjan finishes callees first
+    reverse(components.begin(), components.end());
+}
+
+const vector<vector<string>>& CallGraph::getComponents() const {
+    return components;
+}
+
+const vector<string>& CallGraph::getCallers(const string& address) const {
+    return callers.at(address);
+}
+
+bool CallGraph::isRecursive(const string& address) const {
+    return recursive.count(address);
+}
+
+void CallGraph::findComponents(const string& address) {
+    int number = index.size();
+    index[address] = number;
+    lowLink[address] = number;
+    stack.push_back(address);
+    onStack.insert(address);
+    for (const string& callee : callees.at(address)) {
+        if (!callees.count(callee)) {
+            continue;
+        }
+        if (!index.count(callee)) {
+            findComponents(callee);
+            lowLink[address] = min(lowLink.at(address), lowLink.at(callee));
+        }
+        else if (onStack.count(callee)) {
+            lowLink[address] = min(lowLink.at(address), index.at(callee));
+        }
+    }
+
+    if (lowLink.at(address) == index.at(address)) {
+        vector<string> component;
+        string member;
+        do {
+            member = stack.back();
+            stack.pop_back();
+            onStack.erase(member);
+            component.push_back(member);
+        } while (member != address);
+        if (component.size() > 1) {
+            recursive.insert(component.begin(), component.end());
+        }
+        reverse(component.begin(), component.end());
+        components.push_back(component);
+    }
+}
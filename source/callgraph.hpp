@@ -0,0 +1,31 @@
+#ifndef CALLGRAPH_HPP
+#define CALLGRAPH_HPP
+
+#include "optimizer.hpp"
+
+//calls between the functions of the program by address, array declarations call malloc;
+//functions on a cycle can be active more than once at a time and need their frame on the stack
+class CallGraph {
+public:
+    CallGraph(const vector<shared_ptr<ASTNode>>& ast, const vector<FunctionDescr>&, const unordered_map<string, unordered_map<string, Type>>& variables);
+    //strongly connected components, callers before their callees
+    const vector<vector<string>>& getComponents() const;
+    const vector<string>& getCallers(const string& address) const;
+    bool isRecursive(const string& address) const;
+
+private:
+    vector<string> functions; //in source order
+    unordered_map<string, vector<string>> callees;
+    unordered_map<string, vector<string>> callers;
+    unordered_set<string> recursive;
+    vector<vector<string>> components;
+
+    //Tarjan
+    unordered_map<string, int> index;
+    unordered_map<string, int> lowLink;
+    vector<string> stack;
+    unordered_set<string> onStack;
+    void findComponents(const string& address);
+};
+
+#endif //CALLGRAPH_HPP
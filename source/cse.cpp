@@ -0,0 +1,275 @@
+#include "cse.hpp"
+
+CommonSubexpressionElimination::CommonSubexpressionElimination(OptimizerContext& context) : context(context) {}
+
+void CommonSubexpressionElimination::run(const shared_ptr<FunctionDefinitionNode>& function) {
+    functionName = function->functionName;
+    returnType = function->returnType;
+    definitions.clear();
+
+    ValueTable available;
+    processBlock(function->body, available);
+    insertDefinitions(function->body);
+}
+
+const unordered_map<string, Type>& CommonSubexpressionElimination::variables() {
+    return context.variables.at(functionName);
+}
+
+//values computed in a block stay available in the blocks it dominates, nested blocks work on copies
+void CommonSubexpressionElimination::processBlock(vector<shared_ptr<ASTNode>>& block, ValueTable& available) {
+    for (const shared_ptr<ASTNode>& node : block) {
+        SideEffects effects;
+        collectSideEffects(node, effects);
+
+        if (dynamic_pointer_cast<LabelNode>(node)) {
+            //reachable from any goto
+            available.clear();
+        }
+        else if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+            SideEffects conditionEffects;
+            collectSideEffects(x->condition, conditionEffects);
+            statement = node.get();
+            callInStatement = conditionEffects.hasCall;
+            processExpression(x->condition, Type(TypeType::INT), true, available);
+            ValueTable thenValues = available;
+            processBlock(x->thenBlock, thenValues);
+            ValueTable elseValues = available;
+            processBlock(x->elseBlock, elseValues);
+        }
+        else if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+            //values from before the loop have to survive every iteration
+            ValueTable loopValues = available;
+            invalidate(loopValues, effects);
+            statement = node.get();
+            callInStatement = effects.hasCall;
+            processExpression(x->guard, Type(TypeType::INT), false, loopValues);
+            processBlock(x->preheader, loopValues);
+            invalidate(loopValues, effects);
+            statement = node.get();
+            callInStatement = effects.hasCall;
+            processExpression(x->condition, Type(TypeType::INT), false, loopValues);
+            processBlock(x->body, loopValues);
+        }
+        else if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+            ValueTable loopValues = available;
+            invalidate(loopValues, effects);
+            statement = node.get();
+            callInStatement = effects.hasCall;
+            processExpression(x->guard, Type(TypeType::INT), false, loopValues);
+            processBlock(x->preheader, loopValues);
+            invalidate(loopValues, effects);
+            statement = node.get();
+            callInStatement = effects.hasCall;
+            processExpression(x->condition, Type(TypeType::INT), false, loopValues);
+            processBlock(x->body, loopValues);
+            statement = node.get();
+            callInStatement = effects.hasCall;
+            processStatement(x->update, false, loopValues);
+
+            //the init runs once in front of the loop
+            SideEffects initEffects;
+            collectSideEffects(x->init, initEffects);
+            callInStatement = initEffects.hasCall;
+            processStatement(x->init, true, available);
+        }
+        else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+            processBlock(x->body, available);
+        }
+        else {
+            statement = node.get();
+            //evaluation order around a call is not fixed, memory values are neither used nor defined
+            callInStatement = effects.hasCall;
+            if (callInStatement) {
+                SideEffects callEffects;
+                callEffects.writesMemory = true;
+                invalidate(available, callEffects);
+            }
+            processStatement(node, true, available);
+        }
+
+        invalidate(available, effects);
+    }
+}
+
+//expected types are the ones the generator evaluates the expressions with
+void CommonSubexpressionElimination::processStatement(const shared_ptr<ASTNode>& node, bool define, ValueTable& available) {
+    if (auto x = dynamic_pointer_cast<VariableDeclarationNode>(node)) {
+        processExpression(x->value, x->varType, define, available);
+    }
+    else if (auto x = dynamic_pointer_cast<AssignmentNode>(node)) {
+        Type type = SKIP_IDENT_NAMES.count(x->variable->name) ? Type(TypeType::INT) : variables().at(x->variable->name);
+        if (x->variable->index != nullptr) {
+            type = convertArrayToVarType(type);
+            processExpression(x->variable->index, Type(TypeType::INT), define, available);
+        }
+        processExpression(x->expression, type, define, available);
+    }
+    else if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        processArguments(x, define, available);
+    }
+    else if (auto x = dynamic_pointer_cast<ReturnValueNode>(node)) {
+        processExpression(x->value, returnType, define, available);
+    }
+    else if (auto x = dynamic_pointer_cast<ArrayDeclarationNode>(node)) {
+        Type elementType = convertArrayToVarType(x->type);
+        for (auto& value : x->arrayValues) {
+            processExpression(value, elementType, define, available);
+        }
+    }
+}
+
+void CommonSubexpressionElimination::processArguments(const shared_ptr<FunctionCallNode>& call, bool define, ValueTable& available) {
+    const string& name = call->functionName;
+    if (name == LENGTH_FUNCTION) {
+        return;
+    }
+    if (name == OUTPUT_FUNCTION || name == DREF_FUNCTION || name == SREF_FUNCTION) {
+        //second @sref argument has to stay an identifier
+        processExpression(call->arguments.at(0), Type(TypeType::INT), define, available);
+        return;
+    }
+
+    //resolve before arguments are replaced, temporaries change the argument types
+    FunctionDescr descr = findCallDescr(call, variables(), context.function_descrs);
+    for (int i = 0; i < call->arguments.size(); i++) {
+        processExpression(call->arguments.at(i), descr.params.at(i).second, define, available);
+    }
+}
+
+//define: the expression is evaluated whenever the statement is, not behind && / || or in a loop condition
+void CommonSubexpressionElimination::processExpression(shared_ptr<ASTNode>& slot, const Type& expected_type, bool define, ValueTable& available) {
+    const shared_ptr<ASTNode> node = slot;
+    if (node == nullptr) {
+        return;
+    }
+
+    bool memory = readsMemory(node);
+    bool candidate = isCandidate(node) && !(memory && callInStatement);
+    if (candidate) {
+        for (const shared_ptr<Value>& value : available) {
+            if (value->type.getEnum() == expected_type.getEnum() && equalExpressions(value->expression, node)) {
+                reuseValue(value, slot);
+                return;
+            }
+        }
+    }
+
+    if (auto x = dynamic_pointer_cast<ArithmeticNode>(node)) {
+        processExpression(x->left, expected_type, define, available);
+        processExpression(x->right, expected_type, define, available);
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNode>(node)) {
+        bool shortCircuit = x->logicalType == LogicalType::AND || x->logicalType == LogicalType::OR;
+        processExpression(x->left, Type(TypeType::INT), define, available);
+        processExpression(x->right, Type(TypeType::INT), define && !shortCircuit, available);
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNotNode>(node)) {
+        processExpression(x->operand, Type(TypeType::INT), define, available);
+    }
+    else if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+        processExpression(x->index, Type(TypeType::INT), define, available);
+    }
+    else if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        processArguments(x, define, available);
+    }
+
+    if (candidate && define) {
+        auto value = make_shared<Value>(Value{node, expected_type, &slot, statement, "", {}, memory});
+        collectReadVariables(node, value->reads);
+        available.push_back(value);
+    }
+}
+
+//first reuse: the first evaluation moves into a temporary in front of its statement
+void CommonSubexpressionElimination::reuseValue(const shared_ptr<Value>& value, shared_ptr<ASTNode>& slot) {
+    if (value->temporary.empty()) {
+        value->temporary = context.newTemporary(functionName, "cse", value->type);
+        auto definition = make_shared<AssignmentNode>(make_shared<IdentifierNode>(value->temporary), value->expression);
+        *value->slot = make_shared<IdentifierNode>(value->temporary);
+
+        //in front of the temporaries whose expressions contained this one
+        vector<shared_ptr<AssignmentNode>>& statementDefinitions = definitions[value->statement];
+        auto position = statementDefinitions.begin();
+        for (; position != statementDefinitions.end(); position++) {
+            unordered_set<string> reads;
+            collectReadVariables((*position)->expression, reads);
+            if (reads.count(value->temporary)) {
+                break;
+            }
+        }
+        statementDefinitions.insert(position, definition);
+    }
+    slot = make_shared<IdentifierNode>(value->temporary);
+}
+
+void CommonSubexpressionElimination::insertDefinitions(vector<shared_ptr<ASTNode>>& block) {
+    vector<shared_ptr<ASTNode>> result;
+    for (const shared_ptr<ASTNode>& node : block) {
+        if (definitions.count(node.get())) {
+            const auto& statementDefinitions = definitions.at(node.get());
+            result.insert(result.end(), statementDefinitions.begin(), statementDefinitions.end());
+        }
+        result.push_back(node);
+
+        if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+            insertDefinitions(x->thenBlock);
+            insertDefinitions(x->elseBlock);
+        }
+        else if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+            insertDefinitions(x->preheader);
+            insertDefinitions(x->body);
+        }
+        else if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+            insertDefinitions(x->preheader);
+            insertDefinitions(x->body);
+        }
+        else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+            insertDefinitions(x->body);
+        }
+    }
+    block = result;
+}
+
+void CommonSubexpressionElimination::invalidate(ValueTable& available, const SideEffects& effects) {
+    auto killed = [&](const shared_ptr<Value>& value) {
+        if (effects.writesMemory && value->readsMemory) {
+            return true;
+        }
+        for (const string& read : value->reads) {
+            if (effects.writtenVariables.count(read)) {
+                return true;
+            }
+        }
+        return false;
+    };
+    available.erase(remove_if(available.begin(), available.end(), killed), available.end());
+}
+
+//worth a temporary: arithmetic, array element reads and @dref
+bool CommonSubexpressionElimination::isCandidate(const shared_ptr<ASTNode>& node) {
+    if (dynamic_pointer_cast<ArithmeticNode>(node)) {
+        return true;
+    }
+    if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+        return x->index != nullptr;
+    }
+    if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        return x->functionName == DREF_FUNCTION;
+    }
+    return false;
+}
+
+//array elements, aliases, @dref/@length and @HP/@FREE change with stores and calls
+bool CommonSubexpressionElimination::readsMemory(const shared_ptr<ASTNode>& node) {
+    bool memory = false;
+    visitNodes(node, [&](const shared_ptr<ASTNode>& x) {
+        if (auto identifier = dynamic_pointer_cast<IdentifierNode>(x)) {
+            memory = memory || identifier->index != nullptr || isMemoryAlias(identifier->name) || SKIP_IDENT_NAMES.count(identifier->name);
+        }
+        else if (auto call = dynamic_pointer_cast<FunctionCallNode>(x)) {
+            memory = memory || call->functionName == DREF_FUNCTION || call->functionName == LENGTH_FUNCTION;
+        }
+    });
+    return memory;
+}
@@ -0,0 +1,45 @@
+#ifndef CSE_HPP
+#define CSE_HPP
+
+#include "optimizer.hpp"
+
+//value numbering over a block and the blocks it dominates: a repeated arithmetic expression, array element
+//or @dref is computed once into a temporary, stores and calls invalidate the values
+class CommonSubexpressionElimination {
+public:
+    explicit CommonSubexpressionElimination(OptimizerContext&);
+    void run(const shared_ptr<FunctionDefinitionNode>&);
+
+private:
+    //first evaluation of an expression, the temporary is created on its first reuse
+    struct Value {
+        shared_ptr<ASTNode> expression;
+        Type type;
+        shared_ptr<ASTNode>* slot;
+        ASTNode* statement;
+        string temporary;
+        unordered_set<string> reads;
+        bool readsMemory;
+    };
+    using ValueTable = vector<shared_ptr<Value>>;
+
+    OptimizerContext& context;
+    string functionName;
+    Type returnType;
+    ASTNode* statement = nullptr;
+    bool callInStatement = false;
+    unordered_map<ASTNode*, vector<shared_ptr<AssignmentNode>>> definitions; //statement -> temporaries in front of it
+
+    void processBlock(vector<shared_ptr<ASTNode>>&, ValueTable&);
+    void processStatement(const shared_ptr<ASTNode>&, bool define, ValueTable&);
+    void processExpression(shared_ptr<ASTNode>& slot, const Type& expected_type, bool define, ValueTable&);
+    void processArguments(const shared_ptr<FunctionCallNode>&, bool define, ValueTable&);
+    void reuseValue(const shared_ptr<Value>&, shared_ptr<ASTNode>& slot);
+    void insertDefinitions(vector<shared_ptr<ASTNode>>&);
+    static void invalidate(ValueTable&, const SideEffects&);
+    static bool isCandidate(const shared_ptr<ASTNode>&);
+    static bool readsMemory(const shared_ptr<ASTNode>&);
+    const unordered_map<string, Type>& variables();
+};
+
+#endif //CSE_HPP
@@ -0,0 +1,272 @@
+#include "dce.hpp"
+
+DeadCodeElimination::DeadCodeElimination(OptimizerContext& context) : context(context) {}
+
+void DeadCodeElimination::run(const shared_ptr<FunctionDefinitionNode>& function) {
+    this->function = function;
+    allVariables.clear();
+    for (const auto& [name, type] : context.variables.at(function->functionName)) {
+        allVariables.insert(name);
+    }
+
+    removeUnreachable(function->body);
+    LiveSet live;
+    processBlock(function->body, live, true);
+    removeUnusedVariables();
+}
+
+//statements behind return/goto up to the next label, true if the block never falls through
+bool DeadCodeElimination::removeUnreachable(vector<shared_ptr<ASTNode>>& block) {
+    vector<shared_ptr<ASTNode>> result;
+    bool terminated = false;
+    for (const shared_ptr<ASTNode>& node : block) {
+        if (terminated) {
+            SideEffects effects;
+            collectSideEffects(node, effects);
+            if (!effects.hasLabel) {
+                continue;
+            }
+            terminated = false;
+        }
+        result.push_back(node);
+
+        if (dynamic_pointer_cast<ReturnNode>(node) || dynamic_pointer_cast<ReturnValueNode>(node) || dynamic_pointer_cast<GotoNode>(node)) {
+            terminated = true;
+        }
+        else if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+            bool thenTerminates = removeUnreachable(x->thenBlock);
+            bool elseTerminates = removeUnreachable(x->elseBlock);
+            terminated = thenTerminates && elseTerminates;
+        }
+        else if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+            removeUnreachable(x->preheader);
+            removeUnreachable(x->body);
+        }
+        else if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+            removeUnreachable(x->preheader);
+            removeUnreachable(x->body);
+        }
+        else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+            terminated = removeUnreachable(x->body);
+        }
+    }
+    block = result;
+    return terminated;
+}
+
+//backwards, live: variables read after the block; remove = false only computes the live set
+void DeadCodeElimination::processBlock(vector<shared_ptr<ASTNode>>& block, LiveSet& live, bool remove) {
+    vector<bool> keep(block.size(), true);
+    for (int i = block.size() - 1; i >= 0; i--) {
+        keep[i] = processStatement(block[i], live, remove);
+    }
+
+    if (remove) {
+        vector<shared_ptr<ASTNode>> result;
+        for (int i = 0; i < block.size(); i++) {
+            if (keep[i]) result.push_back(block[i]);
+        }
+        block = result;
+    }
+}
+
+//false if the statement is a dead store, calls of a dead 'x = f(...)' stay as call statement
+bool DeadCodeElimination::processStatement(shared_ptr<ASTNode>& node, LiveSet& live, bool remove) {
+    shared_ptr<ASTNode> value;
+    string target;
+    if (auto x = dynamic_pointer_cast<AssignmentNode>(node)) {
+        if (isLocalStore(x->variable)) {
+            target = x->variable->name;
+        }
+        value = x->expression;
+    }
+    else if (auto x = dynamic_pointer_cast<VariableDeclarationNode>(node)) {
+        target = x->varName;
+        value = x->value;
+    }
+
+    if (dynamic_pointer_cast<AssignmentNode>(node) || dynamic_pointer_cast<VariableDeclarationNode>(node)) {
+        if (!target.empty() && !live.count(target)) {
+            if (!containsCall(value)) {
+                return false;
+            }
+            auto call = dynamic_pointer_cast<FunctionCallNode>(value);
+            if (call && !isBuiltinFunction(call->functionName)) {
+                if (remove) node = call;
+                addReads(call, live);
+                return true;
+            }
+        }
+        live.erase(target);
+        addReads(node, live);
+    }
+    else if (auto x = dynamic_pointer_cast<ArrayDeclarationNode>(node)) {
+        //an unread constant array only sets a pointer to its data, other declarations call malloc
+        if (!live.count(x->name) && hasConstantInitializer(x)) {
+            return false;
+        }
+        live.erase(x->name);
+        addReads(node, live);
+    }
+    else if (dynamic_pointer_cast<ReturnValueNode>(node) || dynamic_pointer_cast<ReturnNode>(node)) {
+        live.clear();
+        addReads(node, live);
+    }
+    else if (dynamic_pointer_cast<LabelNode>(node) || dynamic_pointer_cast<GotoNode>(node)) {
+        live = allVariables;
+    }
+    else if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+        LiveSet elseLive = live;
+        processBlock(x->thenBlock, live, remove);
+        processBlock(x->elseBlock, elseLive, remove);
+        live.insert(elseLive.begin(), elseLive.end());
+        addReads(x->condition, live);
+        //nothing left to branch around, only the calls of the condition stay
+        if (remove && x->thenBlock.empty() && x->elseBlock.empty()) {
+            vector<shared_ptr<ASTNode>> calls;
+            collectConditionCalls(x->condition, calls);
+            if (calls.empty()) {
+                return false;
+            }
+            node = calls.size() == 1 ? calls.at(0) : make_shared<BlockNode>(calls);
+        }
+    }
+    else if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+        processLoop(x->condition, x->guard, x->preheader, x->body, nullptr, live, remove);
+    }
+    else if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+        processLoop(x->condition, x->guard, x->preheader, x->body, &x->update, live, remove);
+        //the init stays, the loop needs it
+        if (!processStatement(x->init, live, false)) {
+            addReads(x->init, live);
+        }
+    }
+    else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+        processBlock(x->body, live, remove);
+    }
+    else {
+        addReads(node, live);
+    }
+    return true;
+}
+
+//guard; preheader; header: if (condition) { body; update; goto header; }
+void DeadCodeElimination::processLoop(const shared_ptr<ASTNode>& condition, const shared_ptr<ASTNode>& guard, vector<shared_ptr<ASTNode>>& preheader,
+                                      vector<shared_ptr<ASTNode>>& body, shared_ptr<ASTNode>* update, LiveSet& live, bool remove) {
+    const LiveSet exitLive = live;
+    auto throughBody = [&](LiveSet& bodyLive, bool removeBody) {
+        if (update != nullptr && !processStatement(*update, bodyLive, false)) {
+            addReads(*update, bodyLive);
+        }
+        processBlock(body, bodyLive, removeBody);
+    };
+
+    //live at the loop header until nothing changes
+    LiveSet header = exitLive;
+    addReads(condition, header);
+    while (true) {
+        LiveSet bodyLive = header;
+        throughBody(bodyLive, false);
+        LiveSet next = exitLive;
+        addReads(condition, next);
+        next.insert(bodyLive.begin(), bodyLive.end());
+        if (next == header) {
+            break;
+        }
+        header = next;
+    }
+
+    if (remove) {
+        LiveSet bodyLive = header;
+        throughBody(bodyLive, true);
+    }
+
+    live = header;
+    processBlock(preheader, live, remove);
+    live.insert(exitLive.begin(), exitLive.end());
+    addReads(guard != nullptr ? guard : condition, live);
+}
+
+//frame slots of variables that are neither read nor written anymore; overloads share one variable map
+void DeadCodeElimination::removeUnusedVariables() {
+    int overloads = 0;
+    for (const FunctionDescr& descr : context.function_descrs) {
+        if (descr.name == function->functionName) overloads++;
+    }
+    if (overloads > 1) {
+        return;
+    }
+
+    unordered_set<string> used;
+    for (const auto& [type, name] : function->parameters) {
+        used.insert(name);
+    }
+    for (const auto& stmt : function->body) {
+        visitNodes(stmt, [&](const shared_ptr<ASTNode>& node) {
+            if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+                used.insert(x->name);
+                if (isMemoryAlias(x->name)) used.insert(x->name.substr(1));
+            }
+            else if (auto x = dynamic_pointer_cast<VariableDeclarationNode>(node)) {
+                used.insert(x->varName);
+            }
+            else if (auto x = dynamic_pointer_cast<ArrayDeclarationNode>(node)) {
+                used.insert(x->name);
+            }
+        });
+    }
+
+    unordered_map<string, Type>& variables = context.variables.at(function->functionName);
+    for (auto it = variables.begin(); it != variables.end();) {
+        if (used.count(it->first)) {
+            it++;
+        }
+        else {
+            it = variables.erase(it);
+        }
+    }
+}
+
+bool DeadCodeElimination::isLocalStore(const shared_ptr<IdentifierNode>& variable) {
+    return variable->index == nullptr && !isMemoryAlias(variable->name) && !SKIP_IDENT_NAMES.count(variable->name);
+}
+
+bool DeadCodeElimination::containsCall(const shared_ptr<ASTNode>& node) {
+    bool found = false;
+    visitNodes(node, [&](const shared_ptr<ASTNode>& x) {
+        auto call = dynamic_pointer_cast<FunctionCallNode>(x);
+        if (call && !isBuiltinFunction(call->functionName)) found = true;
+    });
+    return found;
+}
+
+//calls of a condition without the ones in their arguments, the generator evaluates all of them
+void DeadCodeElimination::collectConditionCalls(const shared_ptr<ASTNode>& node, vector<shared_ptr<ASTNode>>& calls) {
+    if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        if (!isBuiltinFunction(x->functionName)) {
+            calls.push_back(x);
+            return;
+        }
+        for (const shared_ptr<ASTNode>& argument : x->arguments) {
+            collectConditionCalls(argument, calls);
+        }
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNode>(node)) {
+        collectConditionCalls(x->left, calls);
+        collectConditionCalls(x->right, calls);
+    }
+    else if (auto x = dynamic_pointer_cast<ArithmeticNode>(node)) {
+        collectConditionCalls(x->left, calls);
+        collectConditionCalls(x->right, calls);
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNotNode>(node)) {
+        collectConditionCalls(x->operand, calls);
+    }
+    else if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+        collectConditionCalls(x->index, calls);
+    }
+}
+
+void DeadCodeElimination::addReads(const shared_ptr<ASTNode>& statement, LiveSet& live) {
+    collectStatementReads(statement, live);
+}
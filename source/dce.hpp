@@ -0,0 +1,32 @@
+#ifndef DCE_HPP
+#define DCE_HPP
+
+#include "optimizer.hpp"
+
+//removes statements behind return/goto, stores to locals that are not read again (liveness)
+//and variables without any use from the frame
+class DeadCodeElimination {
+public:
+    explicit DeadCodeElimination(OptimizerContext&);
+    void run(const shared_ptr<FunctionDefinitionNode>&);
+
+private:
+    using LiveSet = unordered_set<string>;
+
+    OptimizerContext& context;
+    shared_ptr<FunctionDefinitionNode> function;
+    LiveSet allVariables; //live at labels and gotos
+
+    bool removeUnreachable(vector<shared_ptr<ASTNode>>&);
+    void processBlock(vector<shared_ptr<ASTNode>>&, LiveSet& live, bool remove);
+    bool processStatement(shared_ptr<ASTNode>&, LiveSet& live, bool remove);
+    void processLoop(const shared_ptr<ASTNode>& condition, const shared_ptr<ASTNode>& guard, vector<shared_ptr<ASTNode>>& preheader,
+                     vector<shared_ptr<ASTNode>>& body, shared_ptr<ASTNode>* update, LiveSet& live, bool remove);
+    void removeUnusedVariables();
+    static bool isLocalStore(const shared_ptr<IdentifierNode>&);
+    static bool containsCall(const shared_ptr<ASTNode>&);
+    static void collectConditionCalls(const shared_ptr<ASTNode>&, vector<shared_ptr<ASTNode>>&);
+    static void addReads(const shared_ptr<ASTNode>& statement, LiveSet&);
+};
+
+#endif //DCE_HPP
@@ -0,0 +1,101 @@
+#include "dfe.hpp"
+
+DeadFunctionElimination::DeadFunctionElimination(OptimizerContext& context) : context(context) {}
+
+void DeadFunctionElimination::run(vector<shared_ptr<ASTNode>>& ast) {
+    unordered_map<string, shared_ptr<FunctionDefinitionNode>> definitions; //address -> definition
+    string mallocAddress;
+    for (const shared_ptr<ASTNode>& node : ast) {
+        if (auto function = dynamic_pointer_cast<FunctionDefinitionNode>(node)) {
+            FunctionDescr descr = findFunctionDescr(function, context.function_descrs);
+            definitions[descr.address] = function;
+            if (descr.name == "malloc") mallocAddress = descr.address;
+        }
+    }
+
+    unordered_set<string> reachable;
+    vector<string> worklist;
+    auto reach = [&](const string& address) {
+        if (definitions.count(address) && reachable.insert(address).second) {
+            worklist.push_back(address);
+        }
+    };
+    for (const auto& [address, function] : definitions) {
+        if (function->functionName == "main") reach(address);
+    }
+
+    while (!worklist.empty()) {
+        shared_ptr<FunctionDefinitionNode> function = definitions.at(worklist.back());
+        worklist.pop_back();
+        const unordered_map<string, Type>& variables = context.variables.at(function->functionName);
+        for (const auto& stmt : function->body) {
+            visitNodes(stmt, [&](const shared_ptr<ASTNode>& node) {
+                if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+                    if (!isBuiltinFunction(x->functionName)) {
+                        reach(findCallDescr(x, variables, context.function_descrs).address);
+                    }
+                }
+                else if (dynamic_pointer_cast<ArrayDeclarationNode>(node)) {
+                    reach(mallocAddress);
+                }
+            });
+        }
+    }
+
+    vector<shared_ptr<ASTNode>> result;
+    for (const shared_ptr<ASTNode>& node : ast) {
+        auto function = dynamic_pointer_cast<FunctionDefinitionNode>(node);
+        if (function == nullptr || reachable.count(findFunctionDescr(function, context.function_descrs).address)) {
+            result.push_back(node);
+        }
+    }
+    ast = result;
+}
+
+void removeUnusedStdlibFunctions(vector<shared_ptr<ASTNode>>& ast, size_t firstStdlib) {
+    unordered_map<string, vector<shared_ptr<FunctionDefinitionNode>>> definitions; //name -> overloads
+    for (const shared_ptr<ASTNode>& node : ast) {
+        if (auto function = dynamic_pointer_cast<FunctionDefinitionNode>(node)) {
+            definitions[function->functionName].push_back(function);
+        }
+    }
+
+    unordered_set<string> reachable;
+    vector<string> worklist;
+    auto reach = [&](const string& name) {
+        if (definitions.count(name) && reachable.insert(name).second) {
+            worklist.push_back(name);
+        }
+    };
+    reach("main");
+    //user functions are analyzed even if unused
+    for (size_t i = 0; i < firstStdlib && i < ast.size(); i++) {
+        if (auto function = dynamic_pointer_cast<FunctionDefinitionNode>(ast[i])) reach(function->functionName);
+    }
+
+    while (!worklist.empty()) {
+        string name = worklist.back();
+        worklist.pop_back();
+        for (const auto& function : definitions.at(name)) {
+            for (const auto& stmt : function->body) {
+                visitNodes(stmt, [&](const shared_ptr<ASTNode>& node) {
+                    if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+                        reach(x->functionName);
+                    }
+                    else if (dynamic_pointer_cast<ArrayDeclarationNode>(node)) {
+                        reach("malloc");
+                    }
+                });
+            }
+        }
+    }
+
+    vector<shared_ptr<ASTNode>> result;
+    for (size_t i = 0; i < ast.size(); i++) {
+        auto function = dynamic_pointer_cast<FunctionDefinitionNode>(ast[i]);
+        if (i < firstStdlib || function == nullptr || reachable.count(function->functionName)) {
+            result.push_back(ast[i]);
+        }
+    }
+    ast = result;
+}
@@ -0,0 +1,20 @@
+#ifndef DFE_HPP
+#define DFE_HPP
+
+#include "optimizer.hpp"
+
+//drops functions that main cannot reach, array declarations reach malloc
+class DeadFunctionElimination {
+public:
+    explicit DeadFunctionElimination(OptimizerContext&);
+    //after the optimizer: calls resolved to their overload, inlined callees disappear
+    void run(vector<shared_ptr<ASTNode>>& ast);
+
+private:
+    OptimizerContext& context;
+};
+
+//before the analyzer: the stdlib functions from firstStdlib on, matched by name (overloads stay together)
+void removeUnusedStdlibFunctions(vector<shared_ptr<ASTNode>>& ast, size_t firstStdlib);
+
+#endif //DFE_HPP
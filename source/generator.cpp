@@ -7,18 +7,55 @@
 
 #include "ast.h"
 #include "analyzer.hpp"
+#include "callgraph.hpp"
+#include "optimizer.hpp"
+#include "regalloc.hpp"
 
-string compile(const vector<shared_ptr<ASTNode>>& ast, const vector<FunctionDescr>& function_descrs, const unordered_map<string, unordered_map<string, Type>>& variables) {
+string compile(const vector<shared_ptr<ASTNode>>& ast, const vector<FunctionDescr>& function_descrs, const unordered_map<string, unordered_map<string, Type>>& variables, const OptimizerOptions& options) {
     string output;
     output += "SEG\n";
     output += "MOVE W I H'00FFFF',SP\n";
     output += "MOVEA heap,HP\n";
     output += "CALL main\n";
     output += "HALT\n";
-    for (int i = 0; i < ast.size(); i++) {
-        shared_ptr<FunctionDefinitionNode> func = dynamic_pointer_cast<FunctionDefinitionNode>(ast[i]);
-        Function function = Function(func, variables.at(func->functionName), function_descrs);
-        output += function.getOutput();
+    unordered_map<string, shared_ptr<FunctionDefinitionNode>> definitions;
+    for (const shared_ptr<ASTNode>& node : ast) {
+        shared_ptr<FunctionDefinitionNode> func = dynamic_pointer_cast<FunctionDefinitionNode>(node);
+        definitions[findFunctionDescr(func, function_descrs).address] = func;
+    }
+
+    //callers first: a static frame starts behind the static frames of everything that can call it,
+    //functions that are never active at the same time overlay their frames
+    CallGraph call_graph(ast, function_descrs, variables);
+    unordered_map<string, int> staticFrameEnds;
+    unordered_map<string, string> functionOutputs;
+    string staticData;
+    int staticFramesSize = 0;
+    for (const vector<string>& component : call_graph.getComponents()) {
+        int offset = 0;
+        for (const string& address : component) {
+            for (const string& caller : call_graph.getCallers(address)) {
+                if (staticFrameEnds.count(caller)) offset = max(offset, staticFrameEnds.at(caller));
+            }
+        }
+        for (const string& address : component) {
+            shared_ptr<FunctionDefinitionNode> func = definitions.at(address);
+            bool staticFrame = options.level >= 1 && !call_graph.isRecursive(address);
+            Function function = Function(func, variables.at(func->functionName), function_descrs, options.level >= 1, options.omitFramePointer, staticFrame ? offset : -1);
+            functionOutputs[address] = threadJumps(function.getOutput());
+            staticData += function.getStaticData();
+            staticFrameEnds[address] = offset + function.getStaticFrameSize();
+            staticFramesSize = max(staticFramesSize, staticFrameEnds.at(address));
+        }
+    }
+    for (const shared_ptr<ASTNode>& node : ast) {
+        output += functionOutputs.at(findFunctionDescr(dynamic_pointer_cast<FunctionDefinitionNode>(node), function_descrs).address);
+    }
+
+    //in front of the heap
+    output += staticData;
+    for (int i = 0; i < staticFramesSize; i++) {
+        output += STATIC_FRAME_LABEL+to_string(i)+": DD B 0\n";
     }
     output += "FREE: DD W 0\n";
     output += "HP: DD W 0\n";
@@ -27,39 +64,373 @@ string compile(const vector<shared_ptr<ASTNode>>& ast, const vector<FunctionDesc
     return output;
 }
 
+//peephole on MI text: retarget jumps to JUMPs, drop jumps to the next instruction and dead code after JUMP
+string threadJumps(const string& code) {
+    vector<string> lines;
+    size_t start = 0;
+    while (start < code.size()) {
+        size_t end = code.find('\n', start);
+        if (end == string::npos) end = code.size();
+        lines.push_back(code.substr(start, end - start));
+        start = end + 1;
+    }
+
+    auto isLabel = [](const string& line) { return !line.empty() && line.back() == ':'; };
+    auto isJump = [](const string& line) { return line.size() > 1 && line[0] == 'J' && line.find(' ') != string::npos; };
+    auto jumpTarget = [](const string& line) { return line.substr(line.find(' ') + 1); };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        //label -> first instruction after it
+        unordered_map<string, string> labelInstruction;
+        for (int i = 0; i < lines.size(); i++) {
+            if (!isLabel(lines[i])) continue;
+            int j = i;
+            while (j < lines.size() && (isLabel(lines[j]) || lines[j].empty())) j++;
+            labelInstruction[lines[i].substr(0, lines[i].size() - 1)] = j < lines.size() ? lines[j] : "";
+        }
+
+        vector<string> result;
+        for (int i = 0; i < lines.size(); i++) {
+            string line = lines[i];
+            if (isJump(line)) {
+                //follow JUMP chains
+                string target = jumpTarget(line);
+                unordered_set<string> seen;
+                while (labelInstruction.count(target) && labelInstruction.at(target).rfind("JUMP ", 0) == 0 && !seen.count(target)) {
+                    seen.insert(target);
+                    target = jumpTarget(labelInstruction.at(target));
+                }
+                if (target != jumpTarget(line)) {
+                    line = line.substr(0, line.find(' ') + 1) + target;
+                    changed = true;
+                }
+
+                //jump to one of the directly following labels
+                bool toNext = false;
+                for (int j = i + 1; j < lines.size() && (isLabel(lines[j]) || lines[j].empty()); j++) {
+                    if (lines[j] == target + ":") toNext = true;
+                }
+                if (toNext) {
+                    changed = true;
+                    continue;
+                }
+
+                result.push_back(line);
+
+                //unreachable until next label
+                if (line.rfind("JUMP ", 0) == 0) {
+                    while (i + 1 < lines.size() && !isLabel(lines[i + 1]) && !lines[i + 1].empty()) {
+                        i++;
+                        changed = true;
+                    }
+                }
+                continue;
+            }
+            result.push_back(line);
+        }
+        lines = result;
+    }
+
+    string output;
+    for (int i = 0; i < lines.size(); i++) {
+        output += lines[i];
+        if (i + 1 < lines.size() || (!code.empty() && code.back() == '\n')) output += "\n";
+    }
+    return output;
+}
 
 //Constructor for each Function generator
-Function::Function(const shared_ptr<FunctionDefinitionNode>& functionNode, const unordered_map<string, Type>& variables, const vector<FunctionDescr>& function_descrs) {
+Function::Function(const shared_ptr<FunctionDefinitionNode>& functionNode, const unordered_map<string, Type>& variables, const vector<FunctionDescr>& function_descrs, bool allocateRegisters, bool omitFramePointer, int staticFrameOffset) {
     this->functionName = functionNode->functionName;
+    this->staticFrameOffset = staticFrameOffset;
+    this->omitFramePointer = omitFramePointer;
+    this->framePointer = omitFramePointer ? "FP" : "R13";
     this->function_descr_vector = function_descrs;
     this->function_descr_own = findFunctionDescr(functionNode);
     this->returnLabel = function_descr_own.address+"__return__";
+    //stack parameters are addressed from the frame
+    if (!usesRegisterArguments(function_descr_own) && functionName != "main") {
+        this->staticFrameOffset = -1;
+    }
+    this->staticFrameSize = 0;
+    this->registerLimit = 10;
+    //live ranges for slot sharing and register allocation
+    if (allocateRegisters) {
+        ir = make_shared<IRFunction>(IRBuilder(function_descrs, variables).build(functionNode));
+    }
+    generate(functionNode, variables);
+    if (!allocateRegisters) {
+        return;
+    }
+
+    //the registers the first pass did not need for temporaries hold variables
+    string unallocatedOutput = output;
+    string unallocatedData = staticData;
+    allocateVariableRegisters(variables);
+    if (variableRegisters.empty()) {
+        return;
+    }
+    try {
+        generate(functionNode, variables);
+    } catch (const runtime_error&) {
+        //more temporaries with variables in registers
+        output = unallocatedOutput;
+        staticData = unallocatedData;
+    }
+}
+
+//the saved registers and the frame are only known after the body, tail calls restore them inside it
+void Function::generate(const shared_ptr<FunctionDefinitionNode>& functionNode, const unordered_map<string, Type>& variables) {
+    savedRegisters.clear();
+    usesFramePointer = false;
+    while (true) {
+        generateBody(functionNode, variables);
+        vector<string> saved = findSavedRegisters();
+        bool frame = !omitFramePointer && output.find("!R13") != string::npos;
+        if (saved == savedRegisters && frame == usesFramePointer) {
+            break;
+        }
+        savedRegisters = saved;
+        usesFramePointer = frame;
+    }
+
+    if (omitFramePointer) {
+        try {
+            output = addressFromStackPointer(output);
+        } catch (const runtime_error&) {
+            //R13 may hold a variable already, the caller falls back to the first pass
+            if (!variableRegisters.empty()) {
+                throw;
+            }
+            this->omitFramePointer = false;
+            this->framePointer = "R13";
+            generate(functionNode, variables);
+            return;
+        }
+    }
+
+    //prolog
+    string prolog = function_descr_own.address + ":\n";
+    if (usesFramePointer) {
+        if (functionName != "main") {
+            prolog += "MOVE W R13,-!SP\n";
+        }
+        prolog += "MOVE W SP,R13\n";
+        if (frameSize != 0) {
+            prolog += "SUB W I " + to_string(frameSize) + ",SP\n";
+        }
+    }
+    else if (omitFramePointer && frameSize != 0) {
+        prolog += "SUB W I " + to_string(frameSize) + ",SP\n";
+    }
+    for (const string& reg : savedRegisters) {
+        prolog += "MOVE W "+reg+",-!SP\n";
+    }
+    output = prolog + output;
+
+    //epilog
+    output += returnLabel+":\n";
+    generateEpilog();
+    output += "RET\n\n";
+}
+
+void Function::generateBody(const shared_ptr<FunctionDefinitionNode>& functionNode, const unordered_map<string, Type>& variables) {
+    this->output.clear();
+    this->staticData.clear();
+    this->localVariableMap.clear();
+    this->readOnlyArrays.clear();
     this->localVariablePointerOffset = 0;
     this->paramaterPointerOffset = 0;
     this->jumpLabelNum = 0;
     this->registerNum = 0;
+    //variable registers stay above the incoming arguments
+    this->maxRegisterNum = usesRegisterArguments(function_descr_own) ? function_descr_own.params.size() : 0;
+    this->dataNum = 0;
+    findReadOnlyArrays(functionNode->body);
+
+    frameSize = addVariables(variables);
+
+    //register arguments move to their variable, stack parameters in registers are loaded once
+    for (int i = 0; i < function_descr_own.params.size(); i++) {
+        const auto& [name, type] = function_descr_own.params.at(i);
+        if (usesRegisterArguments(function_descr_own)) {
+            output += "MOVE "+(variableRegisters.count(name) ? string("W") : type.miType())+" R"+to_string(i)+","+localVariableMap.at(name).address+"\n";
+        }
+        else if (variableRegisters.count(name)) {
+            output += "MOVE W "+getParameterAddress(function_descr_own, i)+","+variableRegisters.at(name)+"\n";
+        }
+    }
 
-    //epilog
-    output += function_descr_own.address + ":\n";
+    generateNodes(functionNode->body);
+}
 
-    if (functionName != "main") {
-        output += "PUSHR\n";
+//restores the saved registers and the frame of the caller, SP points to the return address afterwards
+void Function::generateEpilog() {
+    for (int i = savedRegisters.size() - 1; i >= 0; i--) {
+        output += "MOVE W !SP+,"+savedRegisters[i]+"\n";
     }
+    if (usesFramePointer) {
+        output += "MOVE W R13,SP\n";
+        if (functionName != "main") {
+            output += "MOVE W !SP+,R13\n";
+        }
+    }
+    else if (omitFramePointer && frameSize != 0) {
+        output += "ADD W I " + to_string(frameSize) + ",SP\n";
+    }
+}
 
-    output += "MOVE W SP,R13\n";
+//-fomit-frame-pointer: FP is SP at the entry, the pushes and pops up to each instruction are counted
+//and FP relative addresses become SP relative; labels must be reached with the same stack depth
+string Function::addressFromStackPointer(const string& body) {
+    const int base = frameSize + 4 * savedRegisters.size();
+    int depth = 0;
+    bool reachable = true;
+    unordered_map<string, int> labelDepths;
+    auto setLabelDepth = [&](const string& label, int labelDepth) {
+        if (labelDepths.count(label) && labelDepths.at(label) != labelDepth) {
+            throw runtime_error("stack depth differs at "+label);
+        }
+        labelDepths[label] = labelDepth;
+    };
+
+    string result;
+    size_t start = 0;
+    while (start < body.size()) {
+        size_t end = body.find('\n', start);
+        if (end == string::npos) end = body.size();
+        string line = body.substr(start, end - start);
+        start = end + 1;
+
+        if (!line.empty() && line.back() == ':') {
+            string label = line.substr(0, line.size() - 1);
+            //behind an unconditional jump only jumps reach the label, statements start at depth 0
+            if (!reachable) {
+                depth = labelDepths.count(label) ? labelDepths.at(label) : 0;
+                reachable = true;
+            }
+            setLabelDepth(label, depth);
+            result += line + "\n";
+            continue;
+        }
+        size_t space = line.find(' ');
+        string mnemonic = line.substr(0, space);
+        if (mnemonic == "RET") {
+            reachable = false;
+        }
+        if (mnemonic.empty() || space == string::npos || mnemonic[0] == 'J' || mnemonic == "CALL") {
+            if (!mnemonic.empty() && mnemonic[0] == 'J') {
+                setLabelDepth(line.substr(space + 1), depth);
+                reachable = mnemonic != "JUMP";
+            }
+            result += line + "\n";
+            continue;
+        }
 
-    int declaredVariableSize = addVariables(variables);
-    output += "SUB W I " + to_string(declaredVariableSize) + ",SP\n";
+        //MNEMONIC [T] operand,operand[,operand], operands are evaluated in order
+        string type = line.substr(space + 1, line.find(' ', space + 1) - space - 1);
+        if (type.size() != 1 || !isupper(type[0])) {
+            type.clear(); //MOVEA
+        }
+        int size = type == "B" ? 1 : type == "H" ? 2 : 4;
+        vector<string> operands;
+        size_t operandStart = space + 1 + (type.empty() ? 0 : type.size() + 1);
+        while (operandStart <= line.size()) {
+            size_t comma = line.find(',', operandStart);
+            if (comma == string::npos) comma = line.size();
+            operands.push_back(line.substr(operandStart, comma - operandStart));
+            operandStart = comma + 1;
+        }
 
-    generateNodes(functionNode->body);
+        string rewritten = mnemonic + " " + (type.empty() ? "" : type + " ");
+        for (int i = 0; i < operands.size(); i++) {
+            string operand = operands[i];
+            size_t frame = operand.find("+!FP");
+            if (frame != string::npos) {
+                size_t displacementStart = operand.find_last_of("(", frame);
+                displacementStart = displacementStart == string::npos ? 0 : displacementStart + 1;
+                int displacement = stoi(operand.substr(displacementStart, frame - displacementStart)) + base + depth;
+                operand = operand.substr(0, displacementStart) + to_string(displacement) + "+!SP" + operand.substr(frame + 4);
+            }
+            if (operand == "-!SP") {
+                depth += size;
+            }
+            else if (operand == "!SP+") {
+                depth -= size;
+            }
+            else if (operand == "SP" && i + 1 == operands.size()) {
+                //only constant adjustments can be followed
+                if (operands.size() != 2 || operands[0].rfind("I ", 0) != 0 || (mnemonic != "ADD" && mnemonic != "SUB")) {
+                    throw runtime_error("dynamic stack adjustment");
+                }
+                depth += (mnemonic == "SUB" ? 1 : -1) * stoi(operands[0].substr(2));
+            }
+            rewritten += (i != 0 ? "," : "") + operand;
+        }
+        result += rewritten + "\n";
+    }
+    return result;
+}
 
-    //prolog
-    output += returnLabel+":\n";
-    output += "MOVE W R13,SP\n";
-    if (functionName != "main") {
-        output += "POPR\n";
+//registers the body writes that the caller expects back, main has no caller to preserve registers for
+vector<string> Function::findSavedRegisters() {
+    if (functionName == "main") {
+        return {};
     }
-    output += "RET\n\n";
+    //the argument and result registers are not preserved
+    int firstSaved = getClobberedRegisters(function_descr_own);
+    vector<bool> used(14, false);
+    for (size_t i = output.find('R'); i != string::npos; i = output.find('R', i + 1)) {
+        if (i > 0 && (isalnum(output[i - 1]) || output[i - 1] == '_')) {
+            continue;
+        }
+        size_t end = i + 1;
+        while (end < output.size() && isdigit(output[end])) end++;
+        if (end == i + 1 || (end < output.size() && (isalnum(output[end]) || output[end] == '_'))) {
+            continue;
+        }
+        int reg = stoi(output.substr(i + 1, end - i - 1));
+        //R12 is the output register, writing it back would output again; R13 is a variable without frame pointer
+        if (reg < 12 || (reg == 13 && omitFramePointer)) {
+            used[reg] = true;
+        }
+    }
+    vector<string> saved;
+    for (int reg = firstSaved; reg < 14; reg++) {
+        if (used[reg]) saved.push_back("R"+to_string(reg));
+    }
+    return saved;
+}
+
+//word sized locals and parameters, the callee saves the registers it uses
+void Function::allocateVariableRegisters(const unordered_map<string, Type>& variables) {
+    unordered_set<string> candidates;
+    unordered_set<string> parameters;
+    for (const auto& [name, type] : variables) {
+        if (!isMemoryAlias(name) && !SKIP_IDENT_NAMES.count(name) && type.size() == 4 && type.miType() == "W") {
+            candidates.insert(name);
+        }
+    }
+    for (const auto& [name, type] : function_descr_own.params) {
+        parameters.insert(name);
+    }
+
+    vector<string> registers;
+    for (int i = maxRegisterNum; i <= 11; i++) {
+        registers.push_back("R"+to_string(i));
+    }
+    if (omitFramePointer) {
+        registers.push_back("R13");
+    }
+    if (registers.empty()) {
+        return;
+    }
+
+    variableRegisters = LinearScanAllocator(*ir).allocate(candidates, parameters, registers);
+    registerLimit = maxRegisterNum - 1;
 }
 
 //generate "block" of ASTNodes
@@ -84,33 +455,52 @@ void Function::generateNodes(const vector<shared_ptr<ASTNode>>& node) {
             }
 
             FunctionDescr function_descr = findFunctionDescr(function_call_node);
+            if (function_call_node->isTailCall) {
+                generateTailCall(function_call_node, function_descr);
+                continue;
+            }
+            //unused return value
+            int savedRegisterNum = registerNum;
             generateFunctionCall(function_call_node, function_descr);
+            registerNum = savedRegisterNum;
         }
         else if (const shared_ptr<ReturnValueNode>& return_value = dynamic_pointer_cast<ReturnValueNode>(bodyElement) ) {
-            generateAssignment(localVariableMap.at("return"),return_value->value);
+            const shared_ptr<FunctionCallNode> tail_call = dynamic_pointer_cast<FunctionCallNode>(return_value->value);
+            if (tail_call && tail_call->isTailCall) {
+                generateTailCall(tail_call, findFunctionDescr(tail_call));
+                continue;
+            }
+            //the destination is written last, R0 can still serve as temporary
+            generateAssignment({function_descr_own.type, "R0"}, return_value->value);
             output += "JUMP " + returnLabel+"\n";
         }
         else if (const shared_ptr<ReturnNode>& return_node = dynamic_pointer_cast<ReturnNode>(bodyElement)) {
             output += "JUMP " + returnLabel+"\n";
         }
         else if (const shared_ptr<IfNode>& if_node = dynamic_pointer_cast<IfNode>(bodyElement)) {
-            string trueLabel = getNextJumpLabel();
-            string continueLabel = getNextJumpLabel();
-            string reg = getNextRegister();
-            //push condition to stack
-            generateAssignment({Type(TypeType::INT), reg},if_node->condition);
+            //if (cond) goto label; => single conditional jump (bottom test of rotated loops)
+            if (if_node->elseBlock.empty() && if_node->thenBlock.size() == 1) {
+                if (const shared_ptr<GotoNode> goto_node = dynamic_pointer_cast<GotoNode>(if_node->thenBlock.at(0))) {
+                    generateConditionalJump(if_node->condition, "__"+goto_node->label, true);
+                    continue;
+                }
+            }
 
-            output += "MOVE W "+reg+",-!SP\n";
-            clearRegisterNum();
+            string elseLabel = getNextJumpLabel();
 
-            //jump to then/else block
-            output += "MOVE W I 0,-!SP\n";
-            output += "CMP W !SP,4+!SP\n";
-            output += "JNE "+trueLabel+"\n";
-            generateNodes(if_node->elseBlock);
-            output += "JUMP "+continueLabel+"\n";
-            output += trueLabel+":\n";
+            //jump to else block if condition is false, then block falls through
+            generateConditionalJump(if_node->condition, elseLabel, false);
             generateNodes(if_node->thenBlock);
+
+            if (if_node->elseBlock.empty()) {
+                output += elseLabel+":\n";
+                continue;
+            }
+
+            string continueLabel = getNextJumpLabel();
+            output += "JUMP "+continueLabel+"\n";
+            output += elseLabel+":\n";
+            generateNodes(if_node->elseBlock);
             output += continueLabel+":\n";
         }
         else if (const shared_ptr<ArrayDeclarationNode> arr = dynamic_pointer_cast<ArrayDeclarationNode>(bodyElement)) {
@@ -125,9 +515,12 @@ void Function::generateNodes(const vector<shared_ptr<ASTNode>>& node) {
                 elementSize = arr->size;
             }
             int arraySize = elementSize * arrayElementType.size();
+            if (generateStaticArray(arr, local_variable)) {
+                continue;
+            }
             malloc(arraySize+ARRAY_DESCRIPTOR_SIZE, local_variable.address);
 
-            output += "MOVE W I "+ to_string(elementSize)+",!("+local_variable.address+")\n";
+            output += "MOVE W I "+ to_string(elementSize)+","+getIndirectOperand(local_variable.address, 0)+"\n";
 
             if (arr->size == -1) {
                 //fill values
@@ -154,10 +547,20 @@ void Function::generateNodes(const vector<shared_ptr<ASTNode>>& node) {
 void Function::generateAssignment(const LocalVariable& assign_variable, shared_ptr<ASTNode> assign_variable_index, const shared_ptr<ASTNode>& node_expression) {
     string assignment;
     Type assignType;
+    //index and temporary registers are only needed until the store
+    int savedRegisterNum = registerNum;
+    //array element stores have the element type
+    Type targetType = assign_variable_index == nullptr ? assign_variable.type : convertArrayToVarType(assign_variable.type);
+
+    //a[i] = a[i] op e: the element address is computed once and updated in place
+    if (assign_variable_index != nullptr && generateElementUpdate(assign_variable, assign_variable_index, node_expression)) {
+        registerNum = savedRegisterNum;
+        return;
+    }
 
     if (const shared_ptr<NumberNode> numberNode = dynamic_pointer_cast<NumberNode>(node_expression)) {
         assignment = "I " + to_string(numberNode->value);
-        assignType = assign_variable.type;
+        assignType = targetType;
     }
     else if (const shared_ptr<IdentifierNode> identifier_node = dynamic_pointer_cast<IdentifierNode>(node_expression)) {
         LocalVariable local_variable = localVariableMap.at(identifier_node->name);
@@ -176,54 +579,32 @@ void Function::generateAssignment(const LocalVariable& assign_variable, shared_p
     else if (const shared_ptr<FunctionCallNode> function_call_node = dynamic_pointer_cast<FunctionCallNode>(node_expression)) {
         if (function_call_node->functionName == LENGTH_FUNCTION) {
             shared_ptr<IdentifierNode> param1 = dynamic_pointer_cast<IdentifierNode>(function_call_node->arguments.at(0));
-            assignment = localVariableMap.at(param1->name).address;
-            assignment = "!("+assignment+")";
+            assignment = getIndirectOperand(localVariableMap.at(param1->name).address, 0);
             assignType = Type(TypeType::INT);
         }
         else if (function_call_node->functionName == DREF_FUNCTION) {
-            string dref_reg = getNextRegister();
-            auto arg = function_call_node->arguments.at(0);
-
-            generateAssignment({Type(TypeType::INT), dref_reg}, arg);
-
-            assignment = "!"+dref_reg;
-            assignType = assign_variable.type;
-
-            clearRegisterNum();
+            assignment = generatePointerOperand(function_call_node->arguments.at(0));
+            assignType = targetType;
         }
         else {
             FunctionDescr function_call_type = findFunctionDescr(function_call_node);
-            generateFunctionCall(function_call_node, function_call_type);
-            string outputRegister = getNextRegister();
-
-            //pop function return to Rx
-            // output += "MOVE " + function_call_type.type.miType() + " !SP+,"+outputRegister+"\n";
-            // assignment = outputRegister;
-            // assignType = function_call_type.type;
-            // clearRegisterNum();
-
-            assignment = "!SP+";
+            assignment = generateFunctionCall(function_call_node, function_call_type);
             assignType = function_call_type.type;
         }
     }
-    else if (const shared_ptr<LogicalNode> logical_node = dynamic_pointer_cast<LogicalNode>(node_expression)) {
-        generateMathExpression(node_expression, assign_variable.type);
-        assignment = "!SP+";
-        //LogicalExpression is always INT
-        assignType = Type(TypeType::INT);
-    }
-    else if (const shared_ptr<LogicalNotNode>& logical_node = dynamic_pointer_cast<LogicalNotNode>(node_expression)) {
-        generateMathExpression(node_expression, assign_variable.type);
-        assignment = "!SP+";
-        //LogicalExpression is always INT
-        assignType = Type(TypeType::INT);
-    }
-    else if (const shared_ptr<ArithmeticNode>& arithmetic_node = dynamic_pointer_cast<ArithmeticNode>(node_expression)) {
-        //same like logical Node except Type
-        generateMathExpression(node_expression, assign_variable.type);
-        assignment = "!SP+";
-        //type can be casted
-        assignType = assign_variable.type;
+    else if (dynamic_pointer_cast<LogicalNode>(node_expression) || dynamic_pointer_cast<LogicalNotNode>(node_expression) || dynamic_pointer_cast<ArithmeticNode>(node_expression)) {
+        //LogicalExpression is always INT, arithmetic is done in the type of the target
+        assignType = dynamic_pointer_cast<ArithmeticNode>(node_expression) ? targetType : Type(TypeType::INT);
+        //the last operation can write a variable directly
+        string destination;
+        if (assign_variable_index == nullptr && assignType.getEnum() == targetType.getEnum()) {
+            destination = assign_variable.address;
+        }
+        assignment = generateExpression(node_expression, assignType, destination);
+        if (assignment == destination) {
+            registerNum = savedRegisterNum;
+            return;
+        }
     }
     else {
         throw runtime_error("invalid assignment AST Node");
@@ -231,47 +612,186 @@ void Function::generateAssignment(const LocalVariable& assign_variable, shared_p
 
     string assignVariableAddress = getVariableAddress(assign_variable, assign_variable_index);
 
-    if (convertArrayToVarType(assignType).getEnum() != convertArrayToVarType(assign_variable.type).getEnum()) {
+    if (convertArrayToVarType(assignType).getEnum() != convertArrayToVarType(targetType).getEnum()) {
+        //narrow writes to a register zero extend, the low part of a wider value is read in place
+        string source;
+        if (assignType.size() < targetType.size() && assignVariableAddress.rfind("R", 0) == 0) {
+            source = assignment;
+        }
+        else if (assignType.size() > targetType.size()) {
+            source = getLowPartOperand(assignment, assignType.size() - targetType.size());
+        }
+        if (!source.empty()) {
+            string type = assignType.size() < targetType.size() ? assignType.miType() : targetType.miType();
+            output += "MOVE " + type + " " + source + "," + assignVariableAddress + "\n";
+            registerNum = savedRegisterNum;
+            return;
+        }
+
          string shiftReg = getNextRegister();
          output += "MOVE " + assignType.miType() + " " + assignment + ","+shiftReg+"\n";
-         output += "MOVE " + assignType.miType() + " " + shiftReg +  "," + assignVariableAddress + "\n";
+         //narrow writes to a register zero extend, store with the width of the destination
+         output += "MOVE " + targetType.miType() + " " + shiftReg +  "," + assignVariableAddress + "\n";
          clearRegisterNum();
     }
     else {
-        output += "MOVE " + assign_variable.type.miType() + " " + assignment + "," + assignVariableAddress + "\n";
+        output += "MOVE " + targetType.miType() + " " + assignment + "," + assignVariableAddress + "\n";
     }
-
+    registerNum = savedRegisterNum;
 
 }
 
 
-void Function::generateFunctionCall(const shared_ptr<FunctionCallNode>& function_call_node, const FunctionDescr& function_call_type) {
-    //reserve output space
-    int outputSize = function_call_type.type.size();
-    if (outputSize != 0) {
-        output += "SUB W I " + to_string(function_call_type.type.size()) + ",SP\n";
+//returns the register with the result, live temporaries in the registers the callee does not preserve wait on the stack during the call
+string Function::generateFunctionCall(const shared_ptr<FunctionCallNode>& function_call_node, const FunctionDescr& function_call_type) {
+    int clobbered = getClobberedRegisters(function_call_type);
+    //variables are allocated above the argument and result registers
+    maxRegisterNum = max(maxRegisterNum, clobbered);
+    int savedRegisters = min(registerNum, clobbered);
+    for (int i = 0; i < savedRegisters; i++) {
+        output += "MOVE W R"+to_string(i)+",-!SP\n";
     }
 
     int inputSize = 0;
+    if (usesRegisterArguments(function_call_type)) {
+        generateRegisterArguments(function_call_node, function_call_type);
+    }
+    else {
+        //iterate backwards through params and push them on stack
+        for (int i = function_call_type.params.size() - 1; i >= 0; i--) {
+            Type paramType =  function_call_type.params.at(i).second;
+            shared_ptr<ASTNode> arguments_node = function_call_node->arguments.at(i);
+            string reg = getNextRegister();
+            generateAssignment({paramType, reg}, arguments_node);
+            output += "MOVE "+paramType.miType()+" "+reg+",-!SP\n";
+            clearRegisterNum();
+            inputSize += paramType.size();
+        }
+    }
+
+    output += "CALL " + function_call_type.address + "\n";
+
+    //skip params in stack
+    if (inputSize != 0) {
+        output += "ADD W I " + to_string(inputSize) + ",SP\n";
+    }
 
-    //iterate backwards through params and push them on stack
+    string result;
+    if (function_call_type.type.size() != 0) {
+        //narrow results are zero extended, the callee only writes their low part
+        result = getNextRegister();
+        if (result != "R0" || function_call_type.type.size() < 4) {
+            output += "MOVE "+function_call_type.type.miType()+" R0,"+result+"\n";
+        }
+    }
+    for (int i = savedRegisters - 1; i >= 0; i--) {
+        output += "MOVE W !SP+,R"+to_string(i)+"\n";
+    }
+    return result;
+}
+
+//arguments in R0.., the other arguments but one are evaluated onto the stack first
+void Function::generateRegisterArguments(const shared_ptr<FunctionCallNode>& function_call_node, const FunctionDescr& function_call_type) {
+    //direct operands are loaded last, the other arguments but one are evaluated onto the stack first
+    vector<string> operands;
+    vector<int> evaluated;
+    for (int i = 0; i < function_call_type.params.size(); i++) {
+        operands.push_back(getDirectOperand(function_call_node->arguments.at(i), function_call_type.params.at(i).second));
+        if (operands.back().empty()) {
+            evaluated.push_back(i);
+        }
+    }
+    for (int i = 0; i + 1 < static_cast<int>(evaluated.size()); i++) {
+        string reg = getNextRegister();
+        generateAssignment({function_call_type.params.at(evaluated[i]).second, reg}, function_call_node->arguments.at(evaluated[i]));
+        output += "MOVE W "+reg+",-!SP\n";
+        clearRegisterNum();
+    }
+    if (!evaluated.empty()) {
+        int last = evaluated.back();
+        generateAssignment({function_call_type.params.at(last).second, "R"+to_string(last)}, function_call_node->arguments.at(last));
+    }
+    for (int i = static_cast<int>(evaluated.size()) - 2; i >= 0; i--) {
+        output += "MOVE W !SP+,R"+to_string(evaluated[i])+"\n";
+    }
+    for (int i = 0; i < operands.size(); i++) {
+        if (!operands[i].empty()) {
+            output += "MOVE "+function_call_type.params.at(i).second.miType()+" "+operands[i]+",R"+to_string(i)+"\n";
+        }
+    }
+}
+
+//return f(...): the arguments replace the own ones, f returns directly to our caller
+void Function::generateTailCall(const shared_ptr<FunctionCallNode>& function_call_node, const FunctionDescr& function_call_type) {
+    //the epilog keeps the argument registers, they are not saved
+    if (usesRegisterArguments(function_call_type)) {
+        generateRegisterArguments(function_call_node, function_call_type);
+        generateEpilog();
+        output += "JUMP " + function_call_type.address + "\n";
+        return;
+    }
+
+    //all arguments are evaluated before the first parameter is overwritten
     for (int i = function_call_type.params.size() - 1; i >= 0; i--) {
-        Type paramType =  function_call_type.params.at(i).second;
-        shared_ptr<ASTNode> arguments_node = function_call_node->arguments.at(i);
+        Type paramType = function_call_type.params.at(i).second;
         string reg = getNextRegister();
-        generateAssignment({paramType, reg}, arguments_node);
+        generateAssignment({paramType, reg}, function_call_node->arguments.at(i));
         output += "MOVE "+paramType.miType()+" "+reg+",-!SP\n";
         clearRegisterNum();
-        inputSize += paramType.size();
     }
 
-    output += "CALL " + function_call_type.address + "\n";
+    for (int i = 0; i < function_call_type.params.size(); i++) {
+        Type paramType = function_call_type.params.at(i).second;
+        output += "MOVE "+paramType.miType()+" !SP+,"+getParameterAddress(function_call_type, i)+"\n";
+    }
 
-    //skip params in stack
-    if (inputSize != 0) {
-        output += "ADD W I " + to_string(inputSize) + ",SP\n";
+    generateEpilog();
+    output += "JUMP " + function_call_type.address + "\n";
+}
+
+//stack arguments behind the return address and the saved R13 (none in main or without frame pointer)
+string Function::getParameterAddress(const FunctionDescr& descr, int index) {
+    int offset = functionName == "main" || omitFramePointer ? 4 : 8;
+    for (int i = 0; i < index; i++) {
+        offset += descr.params.at(i).second.size();
     }
-    //output is handled outside 'generateFunctionCall'
+    return to_string(offset)+"+!"+framePointer;
+}
+
+//a[i] = a[i] op e and a[i] = e op a[i] for + and *, false if the expression has another form;
+//the operation runs in the element width, operations needing a wider one are left to generateBinaryExpression
+bool Function::generateElementUpdate(const LocalVariable& array, const shared_ptr<ASTNode>& index, const shared_ptr<ASTNode>& node_expression) {
+    const shared_ptr<ArithmeticNode> arithmetic_node = dynamic_pointer_cast<ArithmeticNode>(node_expression);
+    if (arithmetic_node == nullptr || containsFunctionCall(index) || containsFunctionCall(arithmetic_node->right) || containsFunctionCall(arithmetic_node->left)) {
+        return false;
+    }
+    auto isElement = [&](const shared_ptr<ASTNode>& node) {
+        const shared_ptr<IdentifierNode> identifier_node = dynamic_pointer_cast<IdentifierNode>(node);
+        return identifier_node && identifier_node->index != nullptr && localVariableMap.at(identifier_node->name).address == array.address && equalExpressions(identifier_node->index, index);
+    };
+    ArithmeticType arithmetic = arithmetic_node->arithmeticType;
+    shared_ptr<ASTNode> value;
+    if (isElement(arithmetic_node->left)) {
+        value = arithmetic_node->right;
+    }
+    else if ((arithmetic == ArithmeticType::ADD || arithmetic == ArithmeticType::MULTIPLY) && isElement(arithmetic_node->right)) {
+        value = arithmetic_node->left;
+    }
+    else {
+        return false;
+    }
+
+    Type elementType = convertArrayToVarType(array.type);
+    if (needsWideOperation(arithmetic, elementType)) {
+        return false;
+    }
+    string element = generateArrayIndex(array, index);
+    string operand = getDirectOperand(value, elementType);
+    if (operand.empty()) {
+        operand = generateExpression(value, elementType);
+    }
+    generateOperation(arithmetic, elementType, operand, element, element);
+    return true;
 }
 
 //wrapper for index=-1
@@ -287,27 +807,73 @@ int Function::addVariables(const unordered_map<string, Type>& variables) {
     unordered_set<string> params;
     params.reserve(function_descr_own.params.size());
 
-    //param Variables
-    int paramOffset = 0;
-    for (const auto&[name, type]:function_descr_own.params) {
+    //param Variables, register arguments get a slot like locals
+    unordered_map<string, Type> slotTypes;
+    unordered_map<string, int> slotSizes;
+    for (int i = 0; i < function_descr_own.params.size(); i++) {
+        const auto& [name, type] = function_descr_own.params.at(i);
         params.insert(name);
-        string address = to_string(64+paramOffset)+"+!R13";
-        paramOffset += type.size();
-        localVariableMap[name] = {type, address};
+        if (variableRegisters.count(name)) {
+            localVariableMap[name] = {type, variableRegisters.at(name)};
+        }
+        else if (usesRegisterArguments(function_descr_own)) {
+            slotTypes[name] = type;
+            slotSizes[name] = type.size();
+        }
+        else {
+            localVariableMap[name] = {type, getParameterAddress(function_descr_own, i)};
+        }
     }
 
-    //add return variable
-    localVariableMap["return"] = {function_descr_own.type,to_string(64+paramOffset)+"+!R13"};
-
     //local Variables
-    int localOffset = 0;
     for (auto & [name, type]: variables) {
-        if (params.count(name)) {
+        if (params.count(name) || isMemoryAlias(name)) {
             continue;
         }
-        localOffset += type.size();
-        string address = "-"+to_string(localOffset)+"+!R13";
-        localVariableMap[name] = {type, address};
+        if (variableRegisters.count(name)) {
+            localVariableMap[name] = {type, variableRegisters.at(name)};
+            continue;
+        }
+        slotTypes[name] = type;
+        slotSizes[name] = type.size();
+    }
+
+    //frame layout, the same for every run
+    int localOffset = 0;
+    unordered_map<string, int> slots;
+    if (ir) {
+        slots = LinearScanAllocator(*ir).assignSlots(slotSizes, localOffset);
+    }
+    else {
+        vector<string> names;
+        for (const auto& [name, size] : slotSizes) {
+            names.push_back(name);
+        }
+        sort(names.begin(), names.end(), [&](const string& a, const string& b) {
+            return slotSizes.at(a) != slotSizes.at(b) ? slotSizes.at(a) > slotSizes.at(b) : a < b;
+        });
+        for (const string& name : names) {
+            localOffset += slotSizes.at(name);
+            slots[name] = localOffset;
+        }
+    }
+    for (const auto& [name, offset] : slots) {
+        string address = "-"+to_string(offset)+"+!"+framePointer;
+        if (staticFrameOffset >= 0) {
+            address = STATIC_FRAME_LABEL+to_string(staticFrameOffset + offset - slotSizes.at(name));
+        }
+        localVariableMap[name] = {slotTypes.at(name), address};
+    }
+
+    //optimizer aliases: '*p' is the memory p points to, no own slot
+    for (auto & [name, type]: variables) {
+        if (isMemoryAlias(name)) {
+            localVariableMap[name] = {type, getIndirectOperand(localVariableMap.at(name.substr(1)).address, 0)};
+        }
+    }
+    if (staticFrameOffset >= 0) {
+        staticFrameSize = localOffset;
+        return 0;
     }
     return localOffset;
 }
@@ -319,66 +885,191 @@ void Function::generateOutputFunction(const shared_ptr<FunctionCallNode>& output
     generateAssignment({Type(TypeType::INT),"R12"},argumment);
 }
 
-void Function::generateLogicalExpression(const MathExpression& logical_expression) {
-    //generate one operation post ordered elements (stack operations)
+//jump to label if condition evaluates to jumpIfTrue, comparisons become one CMP + Jcc
+void Function::generateConditionalJump(const shared_ptr<ASTNode>& condition, const string& label, bool jumpIfTrue) {
+    if (const shared_ptr<LogicalNotNode> not_node = dynamic_pointer_cast<LogicalNotNode>(condition)) {
+        generateConditionalJump(not_node->operand, label, !jumpIfTrue);
+        return;
+    }
+
+    if (const shared_ptr<LogicalNode> logical_node = dynamic_pointer_cast<LogicalNode>(condition)) {
+        LogicalType logType = logical_node->logicalType;
 
-    LogicalType logType = get<LogicalType>(logical_expression.op);
+        //&& and || are bitwise on values, short circuit only if both sides are 0/1 and right side has no calls
+        if ((logType == LogicalType::AND || logType == LogicalType::OR) && isBooleanCondition(logical_node->left) && isBooleanCondition(logical_node->right) && !containsFunctionCall(logical_node->right)) {
+            //a && b jumps on false if one side is false, a || b jumps on true if one side is true
+            if ((logType == LogicalType::AND) != jumpIfTrue) {
+                generateConditionalJump(logical_node->left, label, jumpIfTrue);
+                generateConditionalJump(logical_node->right, label, jumpIfTrue);
+            }
+            else {
+                string skipLabel = getNextJumpLabel();
+                generateConditionalJump(logical_node->left, skipLabel, !jumpIfTrue);
+                generateConditionalJump(logical_node->right, label, jumpIfTrue);
+                output += skipLabel+":\n";
+            }
+            return;
+        }
 
-    if (logical_expression.expression_L != nullptr) {
-        string pushReg = getNextRegister();
-        generateAssignment({Type(TypeType::INT),pushReg},logical_expression.expression_L);
-        output += "MOVE W " + pushReg + ",-!SP\n";
-        clearRegisterNum();
+        if (logType != LogicalType::AND && logType != LogicalType::OR) {
+            Type compareType = getCompareType(logical_node);
+            string miType = compareType.miType();
+            int usedRegisters = 0;
+            string left = getCompareOperand(logical_node->left, usedRegisters, compareType);
+            //call on the right side could change a variable read directly on the left side
+            if (left.rfind("I ", 0) != 0 && left.rfind("R", 0) != 0 && containsFunctionCall(logical_node->right)) {
+                string reg = getNextRegister();
+                usedRegisters++;
+                output += "MOVE "+miType+" "+left+","+reg+"\n";
+                left = reg;
+            }
+            string right = getCompareOperand(logical_node->right, usedRegisters, compareType);
+
+            //immediate only as first operand
+            if (right.rfind("I ", 0) == 0) {
+                if (left.rfind("I ", 0) == 0) {
+                    string reg = getNextRegister();
+                    usedRegisters++;
+                    output += "MOVE "+miType+" "+left+","+reg+"\n";
+                    left = reg;
+                }
+                else {
+                    swap(left, right);
+                    logType = getMirroredCompare(logType);
+                }
+            }
+
+            output += "CMP "+miType+" "+left+","+right+"\n";
+            output += getCompareJump(jumpIfTrue ? logType : getNegatedCompare(logType))+" "+label+"\n";
+
+            for (int i = 0; i < usedRegisters; i++) {
+                clearRegisterNum();
+            }
+            return;
+        }
     }
 
-    if (logical_expression.expression_R != nullptr) {
-        string pushReg = getNextRegister();
-        generateAssignment({Type(TypeType::INT),pushReg},logical_expression.expression_R);
-        output += "MOVE W " + pushReg + ",-!SP\n";
+    //any other value: compare against 0, char and short values in their width
+    int usedRegisters = 0;
+    Type compareType = getNarrowType(condition);
+    string operand = getCompareOperand(condition, usedRegisters, compareType);
+    output += "CMP "+compareType.miType()+" I 0,"+operand+"\n";
+    output += string(jumpIfTrue ? "JNE " : "JEQ ")+label+"\n";
+    for (int i = 0; i < usedRegisters; i++) {
         clearRegisterNum();
     }
+}
 
-    if (logType == LogicalType::AND) {
-        //ANDNOT s1,s2 => s2 && !s1
-        output += "MOVEC W !SP,!SP\n";
-        output += "ANDNOT W !SP,4+!SP\n";
-        output += "ADD W I 4,SP\n";
+//type of a variable or element read, INT for everything else
+Type Function::getNarrowType(const shared_ptr<ASTNode>& node) {
+    if (const shared_ptr<IdentifierNode> identifier_node = dynamic_pointer_cast<IdentifierNode>(node)) {
+        Type type = localVariableMap.at(identifier_node->name).type;
+        if (identifier_node->index != nullptr) {
+            type = convertArrayToVarType(type);
+        }
+        if (!type.isArray() && type.size() < 4) {
+            return type;
+        }
     }
-    else if (logType == LogicalType::OR) {
-        output += "OR W !SP,4+!SP\n";
-        output += "ADD W I 4,SP\n";
+    return Type(TypeType::INT);
+}
+
+//== and != of values with the same narrow width (or a constant in its range) compare in that width;
+//< and > need the zero extended values, narrow compares are signed
+Type Function::getCompareType(const shared_ptr<LogicalNode>& node) {
+    if (node->logicalType != LogicalType::EQUAL && node->logicalType != LogicalType::NOT_EQUAL) {
+        return Type(TypeType::INT);
     }
-    else if (logType == LogicalType::NOT) {
-        string trueLabel = getNextJumpLabel();
-        string falseLabel = getNextJumpLabel();
+    Type left = getNarrowType(node->left);
+    Type right = getNarrowType(node->right);
+    auto fits = [](const shared_ptr<ASTNode>& constant, const Type& type) {
+        const shared_ptr<NumberNode> number_node = dynamic_pointer_cast<NumberNode>(constant);
+        return number_node && number_node->value >= 0 && number_node->value < (1 << (8 * type.size()));
+    };
+    if (left.size() < 4 && (left.getEnum() == right.getEnum() || fits(node->right, left))) {
+        return left;
+    }
+    if (right.size() < 4 && fits(node->left, right)) {
+        return right;
+    }
+    return Type(TypeType::INT);
+}
 
-        output += "CMP W I 0,!SP\n";
-        output += "JEQ "+trueLabel+"\n";
+//operand for CMP: immediate, variable or @length directly, elements in place, everything else in a register
+string Function::getCompareOperand(const shared_ptr<ASTNode>& node, int& usedRegisters, const Type& type) {
+    string operand = getDirectOperand(node, type);
+    if (!operand.empty()) {
+        return operand;
+    }
+    int savedRegisterNum = registerNum;
+    operand = generateMemoryOperand(node, type);
+    if (!operand.empty()) {
+        usedRegisters += registerNum - savedRegisterNum;
+        return operand;
+    }
 
-        output += "MOVE W I 0,!SP\n";
-        output += "JUMP "+falseLabel+"\n";
+    string reg = getNextRegister();
+    usedRegisters++;
+    generateAssignment({type, reg}, node);
+    return reg;
+}
 
-        output += trueLabel+":\n";
-        output += "MOVE W I 1,!SP\n";
+//true if expression can only be 0 or 1
+bool Function::isBooleanCondition(const shared_ptr<ASTNode>& node) {
+    if (dynamic_pointer_cast<LogicalNotNode>(node)) {
+        return true;
+    }
+    if (const shared_ptr<LogicalNode> logical_node = dynamic_pointer_cast<LogicalNode>(node)) {
+        if (logical_node->logicalType == LogicalType::AND || logical_node->logicalType == LogicalType::OR) {
+            return isBooleanCondition(logical_node->left) && isBooleanCondition(logical_node->right);
+        }
+        return true;
+    }
+    return false;
+}
 
-        output += falseLabel+":\n";
+bool Function::containsFunctionCall(const shared_ptr<ASTNode>& node) {
+    if (node == nullptr) {
+        return false;
     }
-    else {
-        //==,!=,<,<=,>,>=
-        output += "CMP W 4+!SP,!SP\n";
-        string trueLabel = getNextJumpLabel();
-        string falseLabel = getNextJumpLabel();
-        output += getCompareJump(logType) + " " + trueLabel+"\n";
-        //false
-        output += "MOVE W I 0,4+!SP\n";
-        output += "JUMP "+falseLabel+"\n";
+    if (const shared_ptr<FunctionCallNode> function_call_node = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        return function_call_node->functionName != LENGTH_FUNCTION && function_call_node->functionName != DREF_FUNCTION;
+    }
+    if (const shared_ptr<IdentifierNode> identifier_node = dynamic_pointer_cast<IdentifierNode>(node)) {
+        return containsFunctionCall(identifier_node->index);
+    }
+    if (const shared_ptr<LogicalNode> logical_node = dynamic_pointer_cast<LogicalNode>(node)) {
+        return containsFunctionCall(logical_node->left) || containsFunctionCall(logical_node->right);
+    }
+    if (const shared_ptr<ArithmeticNode> arithmetic_node = dynamic_pointer_cast<ArithmeticNode>(node)) {
+        return containsFunctionCall(arithmetic_node->left) || containsFunctionCall(arithmetic_node->right);
+    }
+    if (const shared_ptr<LogicalNotNode> not_node = dynamic_pointer_cast<LogicalNotNode>(node)) {
+        return containsFunctionCall(not_node->operand);
+    }
+    return false;
+}
 
-        //true
-        output += trueLabel+":\n";
-        output += "MOVE W I 1,4+!SP\n";
+LogicalType Function::getNegatedCompare(const LogicalType& logical) {
+    switch (logical) {
+        case LogicalType::EQUAL: return LogicalType::NOT_EQUAL;
+        case LogicalType::NOT_EQUAL: return LogicalType::EQUAL;
+        case LogicalType::LESS_THAN: return LogicalType::GREATER_EQUAL;
+        case LogicalType::GREATER_THAN: return LogicalType::LESS_EQUAL;
+        case LogicalType::LESS_EQUAL: return LogicalType::GREATER_THAN;
+        case LogicalType::GREATER_EQUAL: return LogicalType::LESS_THAN;
+        default: return logical;
+    }
+}
 
-        output += falseLabel+":\n";
-        output += "ADD W I 4,SP\n";
+//a < b <=> b > a
+LogicalType Function::getMirroredCompare(const LogicalType& logical) {
+    switch (logical) {
+        case LogicalType::LESS_THAN: return LogicalType::GREATER_THAN;
+        case LogicalType::GREATER_THAN: return LogicalType::LESS_THAN;
+        case LogicalType::LESS_EQUAL: return LogicalType::GREATER_EQUAL;
+        case LogicalType::GREATER_EQUAL: return LogicalType::LESS_EQUAL;
+        default: return logical;
     }
 }
 
@@ -412,105 +1103,512 @@ string Function::getNextJumpLabel() {
     return output;
 }
 
-void Function::generateArithmeticExpression(const MathExpression& arithmetic_expression, const Type& expected_type) {
-    ArithmeticType ariType = get<ArithmeticType>(arithmetic_expression.op);
+//result in destination or, without one, in a new register that is the lowest register the expression used
+string Function::generateExpression(const shared_ptr<ASTNode>& node, const Type& type, const string& destination) {
+    const shared_ptr<LogicalNode> logical_node = dynamic_pointer_cast<LogicalNode>(node);
+    if (dynamic_pointer_cast<ArithmeticNode>(node) || (logical_node && (logical_node->logicalType == LogicalType::AND || logical_node->logicalType == LogicalType::OR))) {
+        return generateBinaryExpression(node, type, destination);
+    }
 
-    if (arithmetic_expression.expression_L != nullptr) {
-        string pushReg = getNextRegister();
-        generateAssignment({expected_type,pushReg},arithmetic_expression.expression_L);
-        output += "MOVE " + expected_type.miType() +" " + pushReg + ",-!SP\n";
-        clearRegisterNum();
+    //the result register of a call is the lowest one
+    const shared_ptr<FunctionCallNode> function_call_node = dynamic_pointer_cast<FunctionCallNode>(node);
+    if (function_call_node && !isBuiltinFunction(function_call_node->functionName)) {
+        return generateFunctionCall(function_call_node, findFunctionDescr(function_call_node));
     }
 
-    if (arithmetic_expression.expression_R != nullptr) {
-        string pushReg = getNextRegister();
-        generateAssignment({expected_type,pushReg},arithmetic_expression.expression_R);
-        output += "MOVE " + expected_type.miType() +" " + pushReg + ",-!SP\n";
-        clearRegisterNum();
+    string reg = getNextRegister();
+    if (logical_node || dynamic_pointer_cast<LogicalNotNode>(node)) {
+        //comparisons and ! as 0/1 value
+        string falseLabel = getNextJumpLabel();
+        output += "MOVE W I 0,"+reg+"\n";
+        generateConditionalJump(node, falseLabel, false);
+        output += "MOVE W I 1,"+reg+"\n";
+        output += falseLabel+":\n";
+    }
+    else {
+        generateAssignment({type, reg}, node);
     }
+    return reg;
+}
 
-    generateArithmeticOperation(ariType, expected_type);
+//truncating division of narrow values needs them zero extended, MI divides B and H values signed
+bool Function::needsWideOperation(const OperationUnion& op, const Type& type) {
+    return holds_alternative<ArithmeticType>(op) && (get<ArithmeticType>(op) == ArithmeticType::DIVIDE || get<ArithmeticType>(op) == ArithmeticType::MODULO) && type.size() < 4;
 }
 
-void Function::generateArithmeticOperation(const ArithmeticType arithmetic, const Type type) {
-    if (arithmetic == ArithmeticType::MODULO) {
+//Sethi-Ullman order: the side that needs more registers first, the other one is held meanwhile;
+//operands MI can address are not loaded and the stack is only used when the registers run out
+string Function::generateBinaryExpression(const shared_ptr<ASTNode>& node, const Type& type, const string& destination) {
+    shared_ptr<ASTNode> left;
+    shared_ptr<ASTNode> right;
+    OperationUnion op;
+    Type operandType = type;
+    if (const shared_ptr<ArithmeticNode> arithmetic_node = dynamic_pointer_cast<ArithmeticNode>(node)) {
+        left = arithmetic_node->left;
+        right = arithmetic_node->right;
+        op = arithmetic_node->arithmeticType;
+    }
+    else {
+        const shared_ptr<LogicalNode> logical_node = dynamic_pointer_cast<LogicalNode>(node);
+        left = logical_node->left;
+        right = logical_node->right;
+        op = logical_node->logicalType;
+        operandType = Type(TypeType::INT);
+    }
+
+    int savedRegisterNum = registerNum;
+    //only the result is narrowed
+    if (needsWideOperation(op, type)) {
+        string reg = generateBinaryExpression(node, Type(TypeType::INT), "");
+        if (destination.empty()) {
+            return reg;
+        }
+        output += "MOVE "+type.miType()+" "+reg+","+destination+"\n";
+        registerNum = savedRegisterNum;
+        return destination;
+    }
+
+    //reserved, so the second pass with variables in registers decides the same
+    maxRegisterNum = max(maxRegisterNum, min(registerNum + getRegisterNeed(node, operandType, false), registerLimit + 1));
+
+    string leftOperand = getDirectOperand(left, operandType);
+    string rightOperand = getDirectOperand(right, operandType);
+    //call on the right side could change memory read directly on the left side
+    if (leftOperand.rfind("I ", 0) != 0 && leftOperand.rfind("R", 0) != 0 && containsFunctionCall(right)) {
+        leftOperand = "";
+    }
+
+    string result;
+    if (!leftOperand.empty() && !rightOperand.empty()) {
+        result = destination.empty() ? getNextRegister() : destination;
+        generateOperation(op, operandType, rightOperand, leftOperand, result);
+    }
+    else if (!rightOperand.empty()) {
+        string leftReg = generateExpression(left, operandType);
+        result = destination.empty() ? leftReg : destination;
+        generateOperation(op, operandType, rightOperand, leftReg, result);
+    }
+    else if (!leftOperand.empty()) {
+        string rightReg = generateExpression(right, operandType);
+        result = destination.empty() ? rightReg : destination;
+        generateOperation(op, operandType, rightReg, leftOperand, result);
+    }
+    else {
+        int leftNeed = getRegisterNeed(left, operandType, false);
+        int rightNeed = getRegisterNeed(right, operandType, false);
+        //calls keep the order of the source
+        bool leftFirst = leftNeed >= rightNeed || containsFunctionCall(left) || containsFunctionCall(right);
+        const shared_ptr<ASTNode>& first = leftFirst ? left : right;
+        const shared_ptr<ASTNode>& second = leftFirst ? right : left;
+
+        string firstReg = generateExpression(first, operandType);
+        string secondReg;
+        if (registerNum + (leftFirst ? rightNeed : leftNeed) > registerLimit + 1) {
+            //out of registers, the first value waits on the stack
+            output += "MOVE W "+firstReg+",-!SP\n";
+            registerNum = savedRegisterNum;
+            secondReg = generateExpression(second, operandType);
+            firstReg = getNextRegister();
+            output += "MOVE W !SP+,"+firstReg+"\n";
+            result = destination.empty() ? secondReg : destination;
+        }
+        else {
+            //an element or @dref is used in place, only its address needs a register
+            secondReg = generateMemoryOperand(second, operandType);
+            if (secondReg.empty()) {
+                secondReg = generateExpression(second, operandType);
+            }
+            result = destination.empty() ? firstReg : destination;
+        }
+        generateOperation(op, operandType, leftFirst ? secondReg : firstReg, leftFirst ? firstReg : secondReg, result);
+    }
+
+    registerNum = savedRegisterNum + (destination.empty() ? 1 : 0);
+    return result;
+}
+
+//destination = left op right, in place if left is the destination
+void Function::generateOperation(const OperationUnion& op, const Type& type, const string& right, const string& left, const string& destination) {
+    //commutative with the destination on the right: swapped for the in place form
+    bool commutative = holds_alternative<ArithmeticType>(op) ? get<ArithmeticType>(op) == ArithmeticType::ADD || get<ArithmeticType>(op) == ArithmeticType::MULTIPLY : get<LogicalType>(op) == LogicalType::OR;
+    if (commutative && right == destination && left != destination) {
+        generateOperation(op, type, left, right, destination);
+        return;
+    }
+    string operands = left == destination ? right+","+destination : right+","+left+","+destination;
+
+    if (holds_alternative<LogicalType>(op)) {
+        //&& and || are bitwise on values
+        if (get<LogicalType>(op) == LogicalType::OR) {
+            output += "OR W "+operands+"\n";
+            return;
+        }
+        //ANDNOT s1,s2 => s2 && !s1
+        if (right.rfind("I ", 0) == 0) {
+            string complement = "I "+to_string(~stoi(right.substr(2)));
+            output += "ANDNOT W "+(left == destination ? complement+","+destination : complement+","+left+","+destination)+"\n";
+            return;
+        }
         string reg = getNextRegister();
-        output += "DIV "+type.miType()+" !SP,4+!SP,"+reg+"\n"; //temp = a div b
-        output += "MULT "+type.miType()+" !SP,"+reg+"\n"; // temp = b mult temp
-        output += "SUB "+type.miType()+" "+reg+",4+!SP\n"; // erg = a -temp
-        output += "ADD W I 4,SP\n";
+        output += "MOVEC W "+right+","+reg+"\n";
+        output += "ANDNOT W "+(left == destination ? reg+","+destination : reg+","+left+","+destination)+"\n";
         clearRegisterNum();
         return;
     }
 
-    string op = "";
+    ArithmeticType arithmetic = get<ArithmeticType>(op);
+    if (arithmetic == ArithmeticType::MODULO) {
+        //DIV truncates, a % b = a - (a / b) * b
+        string reg = getNextRegister();
+        output += "DIV "+type.miType()+" "+right+","+left+","+reg+"\n";
+        output += "MULT "+type.miType()+" "+right+","+reg+"\n";
+        output += "SUB "+type.miType()+" "+(left == destination ? reg+","+destination : reg+","+left+","+destination)+"\n";
+        clearRegisterNum();
+        return;
+    }
 
+    string opcode;
     switch (arithmetic) {
         case ArithmeticType::ADD:
-            op = "ADD";
+            opcode = "ADD";
             break;
         case ArithmeticType::SUBTRACT:
-            op = "SUB";
+            opcode = "SUB";
             break;
         case ArithmeticType::MULTIPLY:
-            op = "MULT";
+            opcode = "MULT";
             break;
         case ArithmeticType::DIVIDE:
-            op = "DIV";
+            opcode = "DIV";
             break;
-        default: op = "";
+        default:
+            throw runtime_error("invalid arithmetic operation");
     }
-    output += op +" "+type.miType()+" !SP,4+!SP\n";
-    output += "ADD W I 4,SP\n";
+    output += opcode+" "+type.miType()+" "+operands+"\n";
+}
+
+//source operand MI can use without loading it: immediate, variable of the same width, element at a constant index or @length
+string Function::getDirectOperand(const shared_ptr<ASTNode>& node, const Type& type) {
+    if (const shared_ptr<NumberNode> number_node = dynamic_pointer_cast<NumberNode>(node)) {
+        return "I "+to_string(number_node->value);
+    }
+    if (const shared_ptr<IdentifierNode> identifier_node = dynamic_pointer_cast<IdentifierNode>(node)) {
+        const LocalVariable& local_variable = localVariableMap.at(identifier_node->name);
+        //wider values are read in their low part
+        if (identifier_node->index == nullptr) {
+            if (local_variable.type.miType() == type.miType()) {
+                return local_variable.address;
+            }
+            return local_variable.type.size() > type.size() ? getLowPartOperand(local_variable.address, local_variable.type.size() - type.size()) : "";
+        }
+        Type elementType = convertArrayToVarType(local_variable.type);
+        int constant = 0;
+        if (elementType.size() >= type.size() && splitConstantOffset(identifier_node->index, constant) == nullptr) {
+            string operand = getIndirectOperand(local_variable.address, ARRAY_DESCRIPTOR_SIZE + constant * elementType.size());
+            return elementType.size() > type.size() ? getLowPartOperand(operand, elementType.size() - type.size()) : operand;
+        }
+    }
+    if (const shared_ptr<FunctionCallNode> function_call_node = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        if (function_call_node->functionName == LENGTH_FUNCTION && type.miType() == "W") {
+            shared_ptr<IdentifierNode> param1 = dynamic_pointer_cast<IdentifierNode>(function_call_node->arguments.at(0));
+            return getIndirectOperand(localVariableMap.at(param1->name).address, 0);
+        }
+    }
+    return "";
+}
+
+//array element or @dref of the given width as memory operand, its address in at most one new register
+string Function::generateMemoryOperand(const shared_ptr<ASTNode>& node, const Type& type) {
+    if (const shared_ptr<IdentifierNode> identifier_node = dynamic_pointer_cast<IdentifierNode>(node)) {
+        const LocalVariable& local_variable = localVariableMap.at(identifier_node->name);
+        Type elementType = convertArrayToVarType(local_variable.type);
+        if (identifier_node->index != nullptr && elementType.size() >= type.size()) {
+            return getLowPartOperand(generateArrayIndex(local_variable, identifier_node->index), elementType.size() - type.size());
+        }
+    }
+    if (const shared_ptr<FunctionCallNode> function_call_node = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        if (function_call_node->functionName == DREF_FUNCTION) {
+            return generatePointerOperand(function_call_node->arguments.at(0));
+        }
+    }
+    return "";
+}
+
+//Sethi-Ullman number: registers needed to evaluate the expression, 0 if it can be used as operand directly
+int Function::getRegisterNeed(const shared_ptr<ASTNode>& node, const Type& type, bool directOperand) {
+    if (directOperand && !getDirectOperand(node, type).empty()) {
+        return 0;
+    }
+
+    const shared_ptr<LogicalNode> logical_node = dynamic_pointer_cast<LogicalNode>(node);
+    const shared_ptr<ArithmeticNode> arithmetic_node = dynamic_pointer_cast<ArithmeticNode>(node);
+    if (arithmetic_node || (logical_node && (logical_node->logicalType == LogicalType::AND || logical_node->logicalType == LogicalType::OR))) {
+        Type operandType = arithmetic_node ? type : Type(TypeType::INT);
+        const shared_ptr<ASTNode>& left = arithmetic_node ? arithmetic_node->left : logical_node->left;
+        const shared_ptr<ASTNode>& right = arithmetic_node ? arithmetic_node->right : logical_node->right;
+        int leftNeed = getRegisterNeed(left, operandType, true);
+        int rightNeed = getRegisterNeed(right, operandType, true);
+
+        int need;
+        if (leftNeed == 0 || rightNeed == 0) {
+            need = max({leftNeed, rightNeed, 1});
+        }
+        else {
+            need = leftNeed == rightNeed ? leftNeed + 1 : max(leftNeed, rightNeed);
+        }
+        //% and & with a register operand use one more
+        bool temporary = arithmetic_node ? arithmetic_node->arithmeticType == ArithmeticType::MODULO : logical_node->logicalType == LogicalType::AND && dynamic_pointer_cast<NumberNode>(right) == nullptr;
+        if (temporary) {
+            need = max(need, (leftNeed > 0 ? 1 : 0) + (rightNeed > 0 ? 1 : 0) + 1);
+        }
+        return need;
+    }
+    if (logical_node) {
+        //0/1 register and the CMP operands
+        int leftNeed = getRegisterNeed(logical_node->left, Type(TypeType::INT), true);
+        int rightNeed = getRegisterNeed(logical_node->right, Type(TypeType::INT), true);
+        return 1 + max({leftNeed, (leftNeed > 0 ? 1 : 0) + rightNeed, 1});
+    }
+    if (const shared_ptr<LogicalNotNode> not_node = dynamic_pointer_cast<LogicalNotNode>(node)) {
+        return 1 + getRegisterNeed(not_node->operand, Type(TypeType::INT), false);
+    }
+    if (const shared_ptr<IdentifierNode> identifier_node = dynamic_pointer_cast<IdentifierNode>(node)) {
+        if (identifier_node->index != nullptr) {
+            int constant = 0;
+            shared_ptr<ASTNode> variableIndex = splitConstantOffset(identifier_node->index, constant);
+            return variableIndex == nullptr ? 2 : 1 + getRegisterNeed(variableIndex, Type(TypeType::INT), false);
+        }
+        //load with a different width goes through one more register
+        const LocalVariable& local_variable = localVariableMap.at(identifier_node->name);
+        return convertArrayToVarType(local_variable.type).getEnum() != convertArrayToVarType(type).getEnum() ? 2 : 1;
+    }
+    if (const shared_ptr<FunctionCallNode> function_call_node = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        int need = 1;
+        for (const shared_ptr<ASTNode>& argument : function_call_node->arguments) {
+            if (!dynamic_pointer_cast<IdentifierNode>(argument) || function_call_node->functionName != LENGTH_FUNCTION) {
+                need = max(need, 1 + getRegisterNeed(argument, Type(TypeType::INT), false));
+            }
+        }
+        return need;
+    }
+    return 1;
 }
 
 void Function::malloc(int size, const string& assignment) {
-    output += "MOVE W I 0,-!SP\n";
-    output += "MOVE W I "+ to_string(size) + ",-!SP\n";
-    output += "CALL malloc\n";
-    output += "ADD W I 4, SP\n";
-    output += "MOVE W !SP+,"+assignment+"\n";
+    shared_ptr<FunctionCallNode> call = make_shared<FunctionCallNode>("malloc");
+    call->arguments.push_back(make_shared<NumberNode>(size));
+    int savedRegisterNum = registerNum;
+    output += "MOVE W "+generateFunctionCall(call, findFunctionDescr(call))+","+assignment+"\n";
+    registerNum = savedRegisterNum;
 }
 
-//get address to element of array with index and return !Rx (value of indexed element)
+//constant initializer: descriptor and values as DD data, used directly if the array is never written, else copied by words
+bool Function::generateStaticArray(const shared_ptr<ArrayDeclarationNode>& arr, const LocalVariable& local_variable) {
+    if (!hasConstantInitializer(arr)) {
+        return false;
+    }
+    string values;
+    for (const auto& value : arr->arrayValues) {
+        values += (values.empty() ? "" : ",") + to_string(dynamic_pointer_cast<NumberNode>(value)->value);
+    }
+
+    Type arrayElementType = convertArrayToVarType(arr->type);
+    int elementCount = arr->arrayValues.size();
+    //padded to whole words, the copy moves words and following data stays aligned
+    int size = ARRAY_DESCRIPTOR_SIZE + elementCount * arrayElementType.size();
+    int words = (size + 3) / 4;
+
+    string label = function_descr_own.address+"__data__"+to_string(dataNum);
+    dataNum++;
+    staticData += label+": DD W "+to_string(elementCount)+"\n";
+    staticData += "DD "+arrayElementType.miType()+" "+values+"\n";
+    for (int i = size; i < words * 4; i++) {
+        staticData += "DD B 0\n";
+    }
+
+    if (readOnlyArrays.count(arr->name)) {
+        output += "MOVEA "+label+","+local_variable.address+"\n";
+        return true;
+    }
+
+    malloc(words * 4, local_variable.address);
+    string source = getNextRegister();
+    string destination = getNextRegister();
+    output += "MOVEA "+label+","+source+"\n";
+    output += "MOVE W "+local_variable.address+","+destination+"\n";
+    if (words <= UNROLLED_COPY_WORDS) {
+        for (int i = 0; i < words; i++) {
+            output += "MOVE W !"+source+"+,!"+destination+"+\n";
+        }
+    }
+    else {
+        string counter = getNextRegister();
+        string loopLabel = getNextJumpLabel();
+        output += "MOVE W I "+to_string(words)+","+counter+"\n";
+        output += loopLabel+":\n";
+        output += "MOVE W !"+source+"+,!"+destination+"+\n";
+        output += "SUB W I 1,"+counter+"\n";
+        output += "JGT "+loopLabel+"\n";
+        clearRegisterNum();
+    }
+    clearRegisterNum();
+    clearRegisterNum();
+    return true;
+}
+
+//arrays that are only read by index or @length, their constant initializer can stay in the static data
+void Function::findReadOnlyArrays(const vector<shared_ptr<ASTNode>>& body) {
+    unordered_map<string, int> plainUses;
+    unordered_set<string> written;
+    for (const auto& stmt : body) {
+        visitNodes(stmt, [&](const shared_ptr<ASTNode>& node) {
+            if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+                if (x->index == nullptr) plainUses[x->name]++;
+            }
+            else if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+                //@length only reads the descriptor
+                if (x->functionName == LENGTH_FUNCTION) {
+                    if (auto argument = dynamic_pointer_cast<IdentifierNode>(x->arguments.at(0))) plainUses[argument->name]--;
+                }
+            }
+            else if (auto x = dynamic_pointer_cast<AssignmentNode>(node)) {
+                if (x->variable->index != nullptr) written.insert(x->variable->name);
+            }
+        });
+    }
+    for (const auto& stmt : body) {
+        visitNodes(stmt, [&](const shared_ptr<ASTNode>& node) {
+            auto x = dynamic_pointer_cast<ArrayDeclarationNode>(node);
+            if (x && !plainUses[x->name] && !written.count(x->name)) {
+                readOnlyArrays.insert(x->name);
+            }
+        });
+    }
+}
+
+//operand of the indexed element, covers from cheap to expensive:
+//constant index: displacement on the array pointer, no instruction
+//variable index: index * size + array pointer in a register, constant parts of the index in the displacement
 string Function::generateArrayIndex(const LocalVariable& local_variable, shared_ptr<ASTNode> index) {
-    string reg = getNextRegister();
     string address = local_variable.address;
     int arrayElementSize = convertArrayToVarType(local_variable.type).size();
+    int constant = 0;
+    shared_ptr<ASTNode> variableIndex = splitConstantOffset(index, constant);
+    int displacement = ARRAY_DESCRIPTOR_SIZE + constant * arrayElementSize;
+
+    if (variableIndex == nullptr) {
+        string operand = getIndirectOperand(address, displacement);
+        if (!operand.empty()) {
+            return operand;
+        }
+    }
 
-    //output += "MOVE W I "+to_string(index)+","+reg+"\n";
+    string reg = getNextRegister();
+    if (variableIndex == nullptr) {
+        output += "MOVE W "+address+","+reg+"\n";
+        return getIndirectOperand(reg, displacement);
+    }
 
-    generateAssignment({Type(TypeType::INT),reg}, index);
+    string indexOperand = getDirectOperand(variableIndex, Type(TypeType::INT));
+    if (indexOperand.empty()) {
+        generateAssignment({Type(TypeType::INT),reg}, variableIndex);
+        indexOperand = reg;
+    }
+    if (arrayElementSize == 1) {
+        output += "ADD W "+address+","+indexOperand+(indexOperand == reg ? "" : ","+reg)+"\n";
+    }
+    else {
+        output += "MULT W I "+to_string(arrayElementSize)+","+indexOperand+(indexOperand == reg ? "" : ","+reg)+"\n";
+        output += "ADD W "+address+","+reg+"\n";
+    }
+    return getIndirectOperand(reg, displacement);
+}
 
-    output += "MULT W I "+to_string(arrayElementSize)+","+reg+"\n";
-    output += "ADD W "+address + ","+reg+"\n";
-    output += "ADD W I "+to_string(ARRAY_DESCRIPTOR_SIZE)+","+reg+"\n";
+//operand of memory[address] for @dref/@sref: relative to a pointer variable or to the computed address
+string Function::generatePointerOperand(const shared_ptr<ASTNode>& address) {
+    int constant = 0;
+    shared_ptr<ASTNode> pointer = splitConstantOffset(address, constant);
+    if (pointer == nullptr) {
+        pointer = address;
+        constant = 0;
+    }
 
-    return "!"+reg;
+    string operand = getIndirectOperand(getDirectOperand(pointer, Type(TypeType::INT)), constant);
+    if (!operand.empty()) {
+        return operand;
+    }
+    string reg = getNextRegister();
+    generateAssignment({Type(TypeType::INT), reg}, pointer);
+    return getIndirectOperand(reg, constant);
 }
 
-string Function::getVariableAddress(const LocalVariable& local_variable, shared_ptr<ASTNode> index) {
-    if (index == nullptr) {
-        return local_variable.address;
+//operand of the low bytes of a wider value: registers and immediates as they are, memory is big endian;
+//empty for the stack
+string Function::getLowPartOperand(const string& operand, int offset) {
+    if (operand.rfind("R", 0) == 0 || operand.rfind("I ", 0) == 0) {
+        return operand;
     }
-    else {
-        return generateArrayIndex(local_variable, index);
+    if (operand.rfind("!", 0) == 0 && operand.back() != '+') {
+        return to_string(offset)+"+"+operand;
+    }
+    if (operand.rfind(STATIC_FRAME_LABEL, 0) == 0) {
+        return STATIC_FRAME_LABEL+to_string(stoi(operand.substr(STATIC_FRAME_LABEL.size())) + offset);
     }
+    size_t relative = operand.find("+!");
+    if (relative != string::npos && relative > 0 && operand.rfind("-!", 0) != 0) {
+        string displacement = operand.substr(0, relative);
+        if (displacement.find_first_not_of("-0123456789") == string::npos) {
+            return to_string(stoi(displacement) + offset)+operand.substr(relative);
+        }
+    }
+    return "";
 }
 
-//generate post order array with recursive data structure
-void Function::generateMathExpression(const shared_ptr<ASTNode>& node, Type type) {
-    vector<MathExpression> logical_expressions;
-    getMathExpression(node, logical_expressions);
-
-    for (const MathExpression& arithmetic_expression : logical_expressions) {
-        if (holds_alternative<LogicalType>(arithmetic_expression.op)) {
-            generateLogicalExpression(arithmetic_expression);
+//e + c, e - c and c + e: e and c, nullptr for a constant
+shared_ptr<ASTNode> Function::splitConstantOffset(const shared_ptr<ASTNode>& node, int& constant) {
+    if (const shared_ptr<NumberNode> number_node = dynamic_pointer_cast<NumberNode>(node)) {
+        constant += number_node->value;
+        return nullptr;
+    }
+    if (const shared_ptr<ArithmeticNode> arithmetic_node = dynamic_pointer_cast<ArithmeticNode>(node)) {
+        const shared_ptr<NumberNode> left = dynamic_pointer_cast<NumberNode>(arithmetic_node->left);
+        const shared_ptr<NumberNode> right = dynamic_pointer_cast<NumberNode>(arithmetic_node->right);
+        if (arithmetic_node->arithmeticType == ArithmeticType::ADD && right) {
+            constant += right->value;
+            return splitConstantOffset(arithmetic_node->left, constant);
+        }
+        if (arithmetic_node->arithmeticType == ArithmeticType::SUBTRACT && right) {
+            constant -= right->value;
+            return splitConstantOffset(arithmetic_node->left, constant);
         }
-        if (holds_alternative<ArithmeticType>(arithmetic_expression.op)) {
-            generateArithmeticExpression(arithmetic_expression, type);
+        if (arithmetic_node->arithmeticType == ArithmeticType::ADD && left) {
+            constant += left->value;
+            return splitConstantOffset(arithmetic_node->right, constant);
         }
     }
+    return node;
+}
+
+//memory at pointer + displacement: relative to a register, indirect over a variable in memory;
+//empty if the pointer is no register or plain variable
+string Function::getIndirectOperand(const string& pointer, int displacement) {
+    if (pointer.empty() || pointer.rfind("I ", 0) == 0 || pointer.rfind("!", 0) == 0 || pointer.find("!(") != string::npos) {
+        return "";
+    }
+    string prefix = displacement != 0 ? to_string(displacement)+"+" : "";
+    if (pointer.rfind("R", 0) == 0) {
+        return prefix+"!"+pointer;
+    }
+    return prefix+"!("+pointer+")";
+}
+
+string Function::getVariableAddress(const LocalVariable& local_variable, shared_ptr<ASTNode> index) {
+    if (index == nullptr) {
+        return local_variable.address;
+    }
+    else {
+        return generateArrayIndex(local_variable, index);
+    }
 }
 
 void Function::generateSREF(shared_ptr<FunctionCallNode> function_call_node) {
@@ -519,11 +1617,9 @@ void Function::generateSREF(shared_ptr<FunctionCallNode> function_call_node) {
 
     Type type2 = convertArrayToVarType(localVariableMap.at(arg2->name).type);
 
-    string arg1_reg = getNextRegister();
-    generateAssignment({Type(TypeType::INT),arg1_reg}, arg1);
-
-    generateAssignment({type2,"!"+arg1_reg}, arg2);
-    clearRegisterNum();
+    int savedRegisterNum = registerNum;
+    generateAssignment({type2, generatePointerOperand(arg1)}, arg2);
+    registerNum = savedRegisterNum;
 }
 
 Type Function::getType(shared_ptr<ASTNode> node) {
@@ -551,23 +1647,6 @@ Type Function::getType(shared_ptr<ASTNode> node) {
     throw runtime_error("Invalid node type in 'getType()'");
 }
 
-//recursive function for post order array
-shared_ptr<ASTNode> Function::getMathExpression(const shared_ptr<ASTNode>& node, vector<MathExpression>& output) {
-    if (const shared_ptr<LogicalNode> log = dynamic_pointer_cast<LogicalNode>(node)) {
-        output.push_back({getMathExpression(log->left, output), getMathExpression(log->right, output), log->logicalType});
-        return nullptr;
-    }
-    if (const shared_ptr<ArithmeticNode> ari = dynamic_pointer_cast<ArithmeticNode>(node)) {
-        output.push_back({getMathExpression(ari->left, output), getMathExpression(ari->right, output), ari->arithmeticType});
-        return nullptr;
-    }
-    if (const shared_ptr<LogicalNotNode> logNot = dynamic_pointer_cast<LogicalNotNode>(node)) {
-        output.push_back({getMathExpression(logNot->operand, output), nullptr,LogicalType::NOT});
-        return nullptr;
-    }
-    return node;
-}
-
 FunctionDescr Function::findFunctionDescr(shared_ptr<FunctionDefinitionNode> node) {
     for (auto x: function_descr_vector) {
         if (x.name == node->functionName) {
@@ -627,8 +1706,9 @@ string Function::getNextRegister() {
     }
     string output = "R"+to_string(registerNum);
     registerNum++;
+    maxRegisterNum = max(maxRegisterNum, registerNum);
     //R15: PC, R14: SP, R13: BP, R12: OutputReg
-    if (registerNum > 11) {
+    if (registerNum > registerLimit + 1) {
         throw runtime_error("register overflow");
     }
     return output;
@@ -642,3 +1722,11 @@ string Function::getOutput() {
     return output;
 }
 
+string Function::getStaticData() {
+    return staticData;
+}
+
+int Function::getStaticFrameSize() {
+    return staticFrameSize;
+}
+
@@ -16,7 +16,11 @@
 using namespace std;
 
 
-string compile(const vector<shared_ptr<ASTNode>>&, const vector<FunctionDescr>&, const unordered_map<string, unordered_map<string, Type>>&);
+struct OptimizerOptions;
+struct IRFunction;
+
+string compile(const vector<shared_ptr<ASTNode>>&, const vector<FunctionDescr>&, const unordered_map<string, unordered_map<string, Type>>&, const OptimizerOptions&);
+string threadJumps(const string&);
 
 
 struct LocalVariable {
@@ -26,55 +30,94 @@ struct LocalVariable {
 
 using OperationUnion = variant<LogicalType, ArithmeticType>;
 
-struct MathExpression {
-    shared_ptr<ASTNode> expression_L;
-    shared_ptr<ASTNode> expression_R;
-    OperationUnion op;
-};
-
+//frames of functions that cannot recurse, one label per byte
+const string STATIC_FRAME_LABEL = "frame__";
 
 
 class Function {
     public:
-        Function(const shared_ptr<FunctionDefinitionNode>&, const unordered_map<string, Type>&, const vector<FunctionDescr>&);
+        Function(const shared_ptr<FunctionDefinitionNode>&, const unordered_map<string, Type>&, const vector<FunctionDescr>&, bool allocateRegisters, bool omitFramePointer, int staticFrameOffset);
         string getOutput();
+        string getStaticData();
+        int getStaticFrameSize();
 
     private:
         unordered_map<string, LocalVariable> localVariableMap;
         vector<FunctionDescr> function_descr_vector;
         FunctionDescr function_descr_own;
         string output;
+        string staticData; //DD initializers, behind the code
         string functionName;
         string returnLabel;
         int localVariablePointerOffset;
         int paramaterPointerOffset;
         int jumpLabelNum;
         int registerNum;
+        int maxRegisterNum;
+        int registerLimit; //highest register for temporaries, R11 and the ones above the limit hold variables
+        int dataNum;
+        unordered_map<string, string> variableRegisters;
+        shared_ptr<IRFunction> ir; //when optimizing
+        vector<string> savedRegisters; //callee saved, pushed behind the locals
+        bool usesFramePointer; //R13 points to the saved R13 (the return address in main)
+        int frameSize; //bytes of locals below R13
+        int staticFrameOffset; //of the locals in the static frame area, -1 for a frame on the stack
+        int staticFrameSize;
+        bool omitFramePointer; //locals are addressed from SP, R13 holds a variable
+        string framePointer; //base register of the frame addresses, FP is resolved to SP relative addresses at the end
+        unordered_set<string> readOnlyArrays;
         const int ARRAY_DESCRIPTOR_SIZE = 4;
-
+        const int UNROLLED_COPY_WORDS = 4;
+
+        void generate(const shared_ptr<FunctionDefinitionNode>&, const unordered_map<string, Type>&);
+        void generateBody(const shared_ptr<FunctionDefinitionNode>&, const unordered_map<string, Type>&);
+        void generateEpilog();
+        vector<string> findSavedRegisters();
+        string addressFromStackPointer(const string& body);
+        void allocateVariableRegisters(const unordered_map<string, Type>&);
         void generateNodes(const vector<shared_ptr<ASTNode>>&);
         FunctionDescr findFunctionDescr(shared_ptr<FunctionCallNode>);
         FunctionDescr findFunctionDescr(shared_ptr<FunctionDefinitionNode>);
 
-        void generateFunctionCall(const shared_ptr<FunctionCallNode>&, const FunctionDescr&);
+        string generateFunctionCall(const shared_ptr<FunctionCallNode>&, const FunctionDescr&);
+        void generateRegisterArguments(const shared_ptr<FunctionCallNode>&, const FunctionDescr&);
+        string getParameterAddress(const FunctionDescr&, int index);
+        void generateTailCall(const shared_ptr<FunctionCallNode>&, const FunctionDescr&);
         void generateAssignment(const LocalVariable& assign_variable, shared_ptr<ASTNode> index, const shared_ptr<ASTNode>& node_expression);
         void generateAssignment(const LocalVariable& assign_variable, const shared_ptr<ASTNode>& node_expression);
+        bool generateElementUpdate(const LocalVariable& array, const shared_ptr<ASTNode>& index, const shared_ptr<ASTNode>& node_expression);
         int addVariables(const unordered_map<string, Type>&);
         void generateOutputFunction(const shared_ptr<FunctionCallNode>&);
         void generateShift(const Type& from, const LocalVariable& to);
         static string getCompareJump(const LogicalType&);
         string getNextJumpLabel();
-        shared_ptr<ASTNode> getMathExpression(const shared_ptr<ASTNode>&, vector<MathExpression>&);
-        void generateLogicalExpression(const MathExpression&);
-        void generateArithmeticExpression(const MathExpression&, const Type& expected_type);
-        void generateArithmeticOperation(ArithmeticType,Type);
+        void generateConditionalJump(const shared_ptr<ASTNode>& condition, const string& label, bool jumpIfTrue);
+        string getCompareOperand(const shared_ptr<ASTNode>&, int& usedRegisters, const Type&);
+        Type getNarrowType(const shared_ptr<ASTNode>&);
+        Type getCompareType(const shared_ptr<LogicalNode>&);
+        static bool isBooleanCondition(const shared_ptr<ASTNode>&);
+        static bool containsFunctionCall(const shared_ptr<ASTNode>&);
+        static LogicalType getNegatedCompare(const LogicalType&);
+        static LogicalType getMirroredCompare(const LogicalType&);
+        string generateExpression(const shared_ptr<ASTNode>&, const Type&, const string& destination = "");
+        string generateBinaryExpression(const shared_ptr<ASTNode>&, const Type&, const string& destination);
+        static bool needsWideOperation(const OperationUnion&, const Type&);
+        void generateOperation(const OperationUnion&, const Type&, const string& right, const string& left, const string& destination);
+        string getDirectOperand(const shared_ptr<ASTNode>&, const Type&);
+        string generateMemoryOperand(const shared_ptr<ASTNode>&, const Type&);
+        int getRegisterNeed(const shared_ptr<ASTNode>&, const Type&, bool directOperand);
         void malloc(int size, const string& assignment);
+        bool generateStaticArray(const shared_ptr<ArrayDeclarationNode>&, const LocalVariable&);
+        void findReadOnlyArrays(const vector<shared_ptr<ASTNode>>&);
         string generateArrayIndex(const LocalVariable& local_variable, shared_ptr<ASTNode> index);
+        string generatePointerOperand(const shared_ptr<ASTNode>& address);
+        static shared_ptr<ASTNode> splitConstantOffset(const shared_ptr<ASTNode>&, int& constant);
+        static string getIndirectOperand(const string& pointer, int displacement);
+        static string getLowPartOperand(const string& operand, int offset);
 
         string getNextRegister();
         void clearRegisterNum();
         string getVariableAddress(const LocalVariable& local_variable, shared_ptr<ASTNode> index);
-        void generateMathExpression(const shared_ptr<ASTNode>&, Type);
         void generateSREF(shared_ptr<FunctionCallNode>);
         Type getType(shared_ptr<ASTNode>);
 };
@@ -0,0 +1,331 @@
+#include "inliner.hpp"
+
+FunctionInliner::FunctionInliner(OptimizerContext& context, const vector<shared_ptr<ASTNode>>& ast) : context(context) {
+    for (const shared_ptr<ASTNode>& node : ast) {
+        if (auto function = dynamic_pointer_cast<FunctionDefinitionNode>(node)) {
+            definitions[findFunctionDescr(function, context.function_descrs).address] = function;
+        }
+    }
+}
+
+const unordered_map<string, Type>& FunctionInliner::variables() {
+    return context.variables.at(function->functionName);
+}
+
+void FunctionInliner::run(const shared_ptr<FunctionDefinitionNode>& function) {
+    this->function = function;
+    functionAddress = findFunctionDescr(function, context.function_descrs).address;
+    sizeLimit = context.options.level >= 2 ? INLINE_SIZE_O2 : INLINE_SIZE_O1;
+
+    int startSize = 0;
+    for (const auto& stmt : function->body) {
+        startSize += countNodes(stmt);
+    }
+    growthLimit = startSize + INLINE_GROWTH;
+
+    for (int round = 0; round < INLINE_ROUNDS; round++) {
+        changed = false;
+        processBlock(function->body);
+        if (!changed) {
+            break;
+        }
+    }
+}
+
+void FunctionInliner::processBlock(vector<shared_ptr<ASTNode>>& block) {
+    for (shared_ptr<ASTNode>& node : block) {
+        FunctionDescr descr;
+        if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+            if (shouldInline(x, descr)) {
+                string result;
+                node = make_shared<BlockNode>(inlineCall(x, descr, result));
+                changed = true;
+            }
+        }
+        else if (auto x = dynamic_pointer_cast<AssignmentNode>(node)) {
+            auto call = dynamic_pointer_cast<FunctionCallNode>(x->expression);
+            if (call && shouldInline(call, descr)) {
+                node = make_shared<BlockNode>(inlineCall(call, descr, x->variable));
+                changed = true;
+            }
+        }
+        else if (auto x = dynamic_pointer_cast<VariableDeclarationNode>(node)) {
+            auto call = dynamic_pointer_cast<FunctionCallNode>(x->value);
+            if (call && shouldInline(call, descr)) {
+                node = make_shared<BlockNode>(inlineCall(call, descr, make_shared<IdentifierNode>(x->varName)));
+                changed = true;
+            }
+        }
+        else if (auto x = dynamic_pointer_cast<ReturnValueNode>(node)) {
+            auto call = dynamic_pointer_cast<FunctionCallNode>(x->value);
+            if (call && shouldInline(call, descr)) {
+                //the returns of the callee can stay if every path ends with one of the same type
+                bool keepReturns = descr.type.getEnum() == function->returnType.getEnum() && endsWithReturn(definitions.at(descr.address)->body);
+                string result;
+                vector<shared_ptr<ASTNode>> statements = inlineCall(call, descr, result, keepReturns);
+                if (!keepReturns) {
+                    statements.push_back(make_shared<ReturnValueNode>(make_shared<IdentifierNode>(result)));
+                }
+                node = make_shared<BlockNode>(statements);
+                changed = true;
+            }
+        }
+        else if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+            processBlock(x->thenBlock);
+            processBlock(x->elseBlock);
+        }
+        else if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+            processBlock(x->body);
+        }
+        else if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+            processBlock(x->body);
+        }
+        else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+            processBlock(x->body);
+        }
+    }
+}
+
+//not recursive, not overloaded (the variable maps are keyed by name) and small enough
+bool FunctionInliner::shouldInline(const shared_ptr<FunctionCallNode>& call, FunctionDescr& descr) {
+    if (isBuiltinFunction(call->functionName) || call->functionName == "main") {
+        return false;
+    }
+    descr = findCallDescr(call, variables(), context.function_descrs);
+    if (descr.address == functionAddress || !definitions.count(descr.address)) {
+        return false;
+    }
+    for (const FunctionDescr& x : context.function_descrs) {
+        if (x.name == descr.name && x.address != descr.address) {
+            return false;
+        }
+    }
+
+    const shared_ptr<FunctionDefinitionNode>& callee = definitions.at(descr.address);
+    int calleeSize = 0;
+    bool recursive = false;
+    for (const auto& stmt : callee->body) {
+        calleeSize += countNodes(stmt);
+        visitNodes(stmt, [&](const shared_ptr<ASTNode>& node) {
+            auto x = dynamic_pointer_cast<FunctionCallNode>(node);
+            if (x && x->functionName == callee->functionName) recursive = true;
+        });
+    }
+    if (recursive || calleeSize > (callee->isInline ? INLINE_HINT_SIZE : sizeLimit)) {
+        return false;
+    }
+
+    int size = 0;
+    for (const auto& stmt : function->body) {
+        size += countNodes(stmt);
+    }
+    return size + calleeSize <= growthLimit;
+}
+
+//x = f(...): returns write x directly if it has the return type, otherwise through a temporary
+vector<shared_ptr<ASTNode>> FunctionInliner::inlineCall(const shared_ptr<FunctionCallNode>& call, const FunctionDescr& descr, const shared_ptr<IdentifierNode>& target) {
+    string result;
+    bool direct = target->index == nullptr && !isMemoryAlias(target->name) && !SKIP_IDENT_NAMES.count(target->name)
+        && variables().at(target->name).getEnum() == descr.type.getEnum();
+    if (direct) {
+        result = target->name;
+    }
+
+    vector<shared_ptr<ASTNode>> statements = inlineCall(call, descr, result);
+    if (!direct) {
+        statements.push_back(make_shared<AssignmentNode>(target, make_shared<IdentifierNode>(result)));
+    }
+    return statements;
+}
+
+//result: variable for the return value, a new temporary if empty; keepReturns: the call site is 'return f(...)'
+vector<shared_ptr<ASTNode>> FunctionInliner::inlineCall(const shared_ptr<FunctionCallNode>& call, const FunctionDescr& descr, string& result, bool keepReturns) {
+    const shared_ptr<FunctionDefinitionNode>& callee = definitions.at(descr.address);
+    vector<shared_ptr<ASTNode>> body = cloneNodes(callee->body);
+    int inlineNum = context.temporaryNum++;
+
+    //callee locals become temporaries of the caller
+    unordered_map<string, Type> calleeVariables = context.variables.at(callee->functionName);
+    unordered_map<string, string> names;
+    for (const auto& [name, type] : calleeVariables) {
+        if (!isMemoryAlias(name)) {
+            names[name] = context.newTemporary(function->functionName, (name[0] == '%' ? name.substr(1) : name) + "_", type);
+        }
+    }
+    for (const auto& [name, type] : calleeVariables) {
+        if (isMemoryAlias(name)) {
+            names[name] = context.newMemoryAlias(function->functionName, names.at(name.substr(1)), type);
+        }
+    }
+    string labelSuffix = "_inline" + to_string(inlineNum);
+    auto rename = [&](const shared_ptr<ASTNode>& node) {
+        if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+            if (names.count(x->name)) x->name = names.at(x->name);
+        }
+        else if (auto x = dynamic_pointer_cast<VariableDeclarationNode>(node)) {
+            x->varName = names.at(x->varName);
+        }
+        else if (auto x = dynamic_pointer_cast<ArrayDeclarationNode>(node)) {
+            x->name = names.at(x->name);
+        }
+        else if (auto x = dynamic_pointer_cast<LabelNode>(node)) {
+            x->label += labelSuffix;
+        }
+        else if (auto x = dynamic_pointer_cast<GotoNode>(node)) {
+            x->label += labelSuffix;
+        }
+    };
+    for (const auto& stmt : body) {
+        visitNodes(stmt, rename);
+    }
+
+    //constants and variables of the parameter type replace read-only parameters, the others are copied
+    //backwards like the arguments are pushed
+    SideEffects calleeEffects;
+    collectSideEffects(callee->body, calleeEffects);
+    vector<shared_ptr<ASTNode>> statements;
+    for (int i = descr.params.size() - 1; i >= 0; i--) {
+        const auto& [paramName, paramType] = descr.params.at(i);
+        const shared_ptr<ASTNode>& argument = call->arguments.at(i);
+        string parameter = names.at(paramName);
+
+        bool substitute = false;
+        if (!calleeEffects.writtenVariables.count(paramName)) {
+            if (dynamic_pointer_cast<NumberNode>(argument)) {
+                substitute = paramType.getEnum() == TypeType::INT;
+            }
+            else if (auto x = dynamic_pointer_cast<IdentifierNode>(argument)) {
+                substitute = x->index == nullptr && !isMemoryAlias(x->name) && !SKIP_IDENT_NAMES.count(x->name)
+                    && variables().at(x->name).getEnum() == paramType.getEnum();
+            }
+        }
+
+        if (substitute) {
+            for (auto& stmt : body) {
+                stmt = substituteVariable(stmt, parameter, argument);
+            }
+            //indexed accesses of array parameters are renamed
+            if (auto x = dynamic_pointer_cast<IdentifierNode>(argument)) {
+                for (const auto& stmt : body) {
+                    visitNodes(stmt, [&](const shared_ptr<ASTNode>& node) {
+                        auto y = dynamic_pointer_cast<IdentifierNode>(node);
+                        if (y && y->name == parameter) y->name = x->name;
+                    });
+                }
+            }
+        }
+        else {
+            statements.push_back(make_shared<AssignmentNode>(make_shared<IdentifierNode>(parameter), argument));
+        }
+    }
+
+    if (keepReturns) {
+        statements.insert(statements.end(), body.begin(), body.end());
+        return statements;
+    }
+
+    if (descr.type.getEnum() != TypeType::VOID && result.empty()) {
+        result = context.newTemporary(function->functionName, "ret_", descr.type);
+    }
+
+    //early returns become if/else where possible, jumps to the end otherwise
+    vector<shared_ptr<ASTNode>> structured = cloneNodes(body);
+    if (structureReturns(structured)) {
+        replaceReturns(structured, result, "");
+        statements.insert(statements.end(), structured.begin(), structured.end());
+    }
+    else {
+        string endLabel = "inline_end" + to_string(inlineNum);
+        replaceReturns(body, result, endLabel);
+        statements.insert(statements.end(), body.begin(), body.end());
+        statements.push_back(make_shared<LabelNode>(endLabel));
+    }
+    return statements;
+}
+
+//moves statements after 'if (...) { ...; return; }' into the else block, false if a return stays in the middle of the code
+bool FunctionInliner::structureReturns(vector<shared_ptr<ASTNode>>& block) {
+    for (int i = 0; i < block.size(); i++) {
+        const shared_ptr<ASTNode> node = block[i];
+        if (dynamic_pointer_cast<ReturnNode>(node) || dynamic_pointer_cast<ReturnValueNode>(node)) {
+            block.resize(i + 1);
+            return true;
+        }
+
+        auto x = dynamic_pointer_cast<IfNode>(node);
+        if (x && containsReturn(x)) {
+            vector<shared_ptr<ASTNode>> rest(block.begin() + i + 1, block.end());
+            block.resize(i + 1);
+
+            bool thenReturns = endsWithReturn(x->thenBlock);
+            bool elseReturns = endsWithReturn(x->elseBlock);
+            if (!rest.empty() && !(thenReturns && elseReturns)) {
+                if (thenReturns) {
+                    x->elseBlock.insert(x->elseBlock.end(), rest.begin(), rest.end());
+                }
+                else if (elseReturns) {
+                    x->thenBlock.insert(x->thenBlock.end(), rest.begin(), rest.end());
+                }
+                else {
+                    return false;
+                }
+            }
+            return structureReturns(x->thenBlock) && structureReturns(x->elseBlock);
+        }
+
+        if (containsReturn(node)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void FunctionInliner::replaceReturns(vector<shared_ptr<ASTNode>>& block, const string& result, const string& endLabel) {
+    for (shared_ptr<ASTNode>& node : block) {
+        if (auto x = dynamic_pointer_cast<ReturnValueNode>(node)) {
+            vector<shared_ptr<ASTNode>> statements = {make_shared<AssignmentNode>(make_shared<IdentifierNode>(result), x->value)};
+            if (!endLabel.empty()) {
+                statements.push_back(make_shared<GotoNode>(endLabel));
+            }
+            node = make_shared<BlockNode>(statements);
+        }
+        else if (dynamic_pointer_cast<ReturnNode>(node)) {
+            node = endLabel.empty() ? static_pointer_cast<ASTNode>(make_shared<BlockNode>(vector<shared_ptr<ASTNode>>{})) : make_shared<GotoNode>(endLabel);
+        }
+        else if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+            replaceReturns(x->thenBlock, result, endLabel);
+            replaceReturns(x->elseBlock, result, endLabel);
+        }
+        else if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+            replaceReturns(x->body, result, endLabel);
+        }
+        else if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+            replaceReturns(x->body, result, endLabel);
+        }
+        else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+            replaceReturns(x->body, result, endLabel);
+        }
+    }
+}
+
+bool FunctionInliner::endsWithReturn(const vector<shared_ptr<ASTNode>>& block) {
+    if (block.empty()) {
+        return false;
+    }
+    const shared_ptr<ASTNode>& last = block.back();
+    if (dynamic_pointer_cast<ReturnNode>(last) || dynamic_pointer_cast<ReturnValueNode>(last)) {
+        return true;
+    }
+    if (auto x = dynamic_pointer_cast<IfNode>(last)) {
+        return endsWithReturn(x->thenBlock) && endsWithReturn(x->elseBlock);
+    }
+    return false;
+}
+
+bool FunctionInliner::containsReturn(const shared_ptr<ASTNode>& node) {
+    bool found = false;
+    visitNodes(node, [&](const shared_ptr<ASTNode>& x) {
+        if (dynamic_pointer_cast<ReturnNode>(x) || dynamic_pointer_cast<ReturnValueNode>(x)) found = true;
+    });
+    return found;
+}
@@ -0,0 +1,41 @@
+#ifndef INLINER_HPP
+#define INLINER_HPP
+
+#include "optimizer.hpp"
+
+//replaces call statements, 'x = f(...)' and 'return f(...)' by the renamed body of small or 'inline' functions
+class FunctionInliner {
+public:
+    FunctionInliner(OptimizerContext&, const vector<shared_ptr<ASTNode>>& ast);
+    void run(const shared_ptr<FunctionDefinitionNode>&);
+
+private:
+    //AST nodes of a callee body that are inlined without hint, depending on the -O level
+    static const int INLINE_SIZE_O1 = 12;
+    static const int INLINE_SIZE_O2 = 40;
+    //upper limit for 'inline' functions and growth of one caller
+    static const int INLINE_HINT_SIZE = 200;
+    static const int INLINE_GROWTH = 400;
+    //inlined bodies can contain further calls
+    static const int INLINE_ROUNDS = 3;
+
+    OptimizerContext& context;
+    unordered_map<string, shared_ptr<FunctionDefinitionNode>> definitions; //address -> definition
+    shared_ptr<FunctionDefinitionNode> function;
+    string functionAddress;
+    int sizeLimit = 0;
+    int growthLimit = 0;
+    bool changed = false;
+
+    void processBlock(vector<shared_ptr<ASTNode>>&);
+    bool shouldInline(const shared_ptr<FunctionCallNode>&, FunctionDescr&);
+    vector<shared_ptr<ASTNode>> inlineCall(const shared_ptr<FunctionCallNode>&, const FunctionDescr&, string& result, bool keepReturns = false);
+    vector<shared_ptr<ASTNode>> inlineCall(const shared_ptr<FunctionCallNode>&, const FunctionDescr&, const shared_ptr<IdentifierNode>& target);
+    bool structureReturns(vector<shared_ptr<ASTNode>>&);
+    void replaceReturns(vector<shared_ptr<ASTNode>>&, const string& result, const string& endLabel);
+    static bool endsWithReturn(const vector<shared_ptr<ASTNode>>&);
+    static bool containsReturn(const shared_ptr<ASTNode>&);
+    const unordered_map<string, Type>& variables();
+};
+
+#endif //INLINER_HPP
@@ -0,0 +1,216 @@
+#include "interpreter.hpp"
+
+#include <climits>
+#include <cstdint>
+
+Interpreter::Interpreter(OptimizerContext& context, const unordered_map<string, shared_ptr<FunctionDefinitionNode>>& definitions, int stepBudget)
+    : context(context), definitions(definitions), stepBudget(stepBudget) {}
+
+bool Interpreter::call(const FunctionDescr& descr, const vector<int>& arguments, int& result) {
+    steps = 0;
+    depth = 0;
+    try {
+        result = invoke(descr, arguments);
+        return true;
+    }
+    catch (const Unsupported&) {
+        return false;
+    }
+}
+
+int Interpreter::invoke(const FunctionDescr& descr, const vector<int>& arguments) {
+    if (!definitions.count(descr.address) || depth >= MAX_DEPTH) {
+        throw Unsupported();
+    }
+    const shared_ptr<FunctionDefinitionNode>& function = definitions.at(descr.address);
+
+    Frame frame;
+    frame.functionName = function->functionName;
+    for (int i = 0; i < function->parameters.size(); i++) {
+        frame.values[function->parameters.at(i).second] = arguments.at(i);
+    }
+
+    depth++;
+    int result = 0;
+    if (!executeBlock(function->body, frame, result)) {
+        //falls off the end without a value
+        throw Unsupported();
+    }
+    depth--;
+    return result;
+}
+
+//true if a return was executed
+bool Interpreter::executeBlock(const vector<shared_ptr<ASTNode>>& block, Frame& frame, int& result) {
+    for (const shared_ptr<ASTNode>& node : block) {
+        if (execute(node, frame, result)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Interpreter::execute(const shared_ptr<ASTNode>& node, Frame& frame, int& result) {
+    step();
+    if (auto x = dynamic_pointer_cast<VariableDeclarationNode>(node)) {
+        if (x->value != nullptr) {
+            frame.values[x->varName] = evaluate(x->value, frame);
+        }
+        else {
+            frame.values.erase(x->varName);
+        }
+    }
+    else if (auto x = dynamic_pointer_cast<AssignmentNode>(node)) {
+        if (x->variable->index != nullptr || isMemoryAlias(x->variable->name) || SKIP_IDENT_NAMES.count(x->variable->name)) {
+            throw Unsupported();
+        }
+        frame.values[x->variable->name] = evaluate(x->expression, frame);
+    }
+    else if (auto x = dynamic_pointer_cast<ReturnValueNode>(node)) {
+        result = evaluate(x->value, frame);
+        return true;
+    }
+    else if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+        return executeBlock(evaluateCondition(x->condition, frame) ? x->thenBlock : x->elseBlock, frame, result);
+    }
+    else if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+        return executeLoop(x->condition, x->guard, x->preheader, x->body, nullptr, frame, result);
+    }
+    else if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+        if (x->init != nullptr && execute(x->init, frame, result)) {
+            return true;
+        }
+        return executeLoop(x->condition, x->guard, x->preheader, x->body, x->update, frame, result);
+    }
+    else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+        return executeBlock(x->body, frame, result);
+    }
+    else if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        evaluate(x, frame);
+    }
+    else {
+        //return without value, labels, gotos, arrays
+        throw Unsupported();
+    }
+    return false;
+}
+
+//guard; preheader; while (condition) { body; update; }
+bool Interpreter::executeLoop(const shared_ptr<ASTNode>& condition, const shared_ptr<ASTNode>& guard, const vector<shared_ptr<ASTNode>>& preheader,
+                              const vector<shared_ptr<ASTNode>>& body, const shared_ptr<ASTNode>& update, Frame& frame, int& result) {
+    if (!evaluateCondition(guard != nullptr ? guard : condition, frame)) {
+        return false;
+    }
+    if (executeBlock(preheader, frame, result)) {
+        return true;
+    }
+    do {
+        if (executeBlock(body, frame, result)) {
+            return true;
+        }
+        if (update != nullptr && execute(update, frame, result)) {
+            return true;
+        }
+    } while (evaluateCondition(condition, frame));
+    return false;
+}
+
+int Interpreter::evaluate(const shared_ptr<ASTNode>& node, Frame& frame) {
+    step();
+    if (auto x = dynamic_pointer_cast<NumberNode>(node)) {
+        return x->value;
+    }
+    if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+        //uninitialized variables have no value to compute with
+        if (x->index != nullptr || !frame.values.count(x->name)) {
+            throw Unsupported();
+        }
+        return frame.values.at(x->name);
+    }
+    if (auto x = dynamic_pointer_cast<ArithmeticNode>(node)) {
+        int64_t left = evaluate(x->left, frame);
+        int64_t right = evaluate(x->right, frame);
+        int64_t value;
+        switch (x->arithmeticType) {
+            case ArithmeticType::ADD: value = left + right; break;
+            case ArithmeticType::SUBTRACT: value = left - right; break;
+            case ArithmeticType::MULTIPLY: value = left * right; break;
+            case ArithmeticType::DIVIDE:
+            case ArithmeticType::MODULO:
+                if (right == 0 || (left == INT_MIN && right == -1)) {
+                    throw Unsupported();
+                }
+                //MI DIV truncates towards zero like C++, modulo is a - (a / b) * b
+                value = x->arithmeticType == ArithmeticType::DIVIDE ? left / right : left % right;
+                break;
+        }
+        //wraps around like the W operations
+        return static_cast<int32_t>(static_cast<uint32_t>(value));
+    }
+    if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        if (isBuiltinFunction(x->functionName)) {
+            throw Unsupported();
+        }
+        FunctionDescr descr = findCallDescr(x, context.variables.at(frame.functionName), context.function_descrs);
+        vector<int> arguments;
+        for (const auto& argument : x->arguments) {
+            arguments.push_back(evaluate(argument, frame));
+        }
+        return invoke(descr, arguments);
+    }
+    //0/1 values of comparisons are only used as conditions
+    throw Unsupported();
+}
+
+bool Interpreter::evaluateCondition(const shared_ptr<ASTNode>& node, Frame& frame) {
+    step();
+    if (auto x = dynamic_pointer_cast<LogicalNotNode>(node)) {
+        return !evaluateCondition(x->operand, frame);
+    }
+    auto x = dynamic_pointer_cast<LogicalNode>(node);
+    if (x == nullptr) {
+        throw Unsupported();
+    }
+
+    if (x->logicalType == LogicalType::AND || x->logicalType == LogicalType::OR) {
+        //bitwise on values otherwise
+        if (!isBoolean(x->left) || !isBoolean(x->right)) {
+            throw Unsupported();
+        }
+        //both sides, the generated code may evaluate the right side anyway
+        bool left = evaluateCondition(x->left, frame);
+        bool right = evaluateCondition(x->right, frame);
+        return x->logicalType == LogicalType::AND ? left && right : left || right;
+    }
+
+    int left = evaluate(x->left, frame);
+    int right = evaluate(x->right, frame);
+    switch (x->logicalType) {
+        case LogicalType::EQUAL: return left == right;
+        case LogicalType::NOT_EQUAL: return left != right;
+        case LogicalType::LESS_THAN: return left < right;
+        case LogicalType::GREATER_THAN: return left > right;
+        case LogicalType::LESS_EQUAL: return left <= right;
+        case LogicalType::GREATER_EQUAL: return left >= right;
+        default: throw Unsupported();
+    }
+}
+
+void Interpreter::step() {
+    if (++steps > stepBudget) {
+        throw Unsupported();
+    }
+}
+
+bool Interpreter::isBoolean(const shared_ptr<ASTNode>& node) {
+    if (dynamic_pointer_cast<LogicalNotNode>(node)) {
+        return true;
+    }
+    if (auto x = dynamic_pointer_cast<LogicalNode>(node)) {
+        if (x->logicalType == LogicalType::AND || x->logicalType == LogicalType::OR) {
+            return isBoolean(x->left) && isBoolean(x->right);
+        }
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,39 @@
+#ifndef INTERPRETER_HPP
+#define INTERPRETER_HPP
+
+#include "optimizer.hpp"
+
+//evaluates calls of int functions without memory access on the AST, like the generated code would (32 bit, DIV truncates)
+class Interpreter {
+public:
+    Interpreter(OptimizerContext&, const unordered_map<string, shared_ptr<FunctionDefinitionNode>>& definitions, int stepBudget);
+    //false if the call runs out of steps or needs something the interpreter cannot evaluate
+    bool call(const FunctionDescr&, const vector<int>& arguments, int& result);
+
+private:
+    static const int MAX_DEPTH = 200;
+
+    struct Frame {
+        string functionName;
+        unordered_map<string, int> values;
+    };
+    struct Unsupported {};
+
+    OptimizerContext& context;
+    const unordered_map<string, shared_ptr<FunctionDefinitionNode>>& definitions; //address -> definition
+    int stepBudget;
+    int steps = 0;
+    int depth = 0;
+
+    int invoke(const FunctionDescr&, const vector<int>& arguments);
+    bool executeBlock(const vector<shared_ptr<ASTNode>>&, Frame&, int& result);
+    bool execute(const shared_ptr<ASTNode>&, Frame&, int& result);
+    bool executeLoop(const shared_ptr<ASTNode>& condition, const shared_ptr<ASTNode>& guard, const vector<shared_ptr<ASTNode>>& preheader,
+                     const vector<shared_ptr<ASTNode>>& body, const shared_ptr<ASTNode>& update, Frame&, int& result);
+    int evaluate(const shared_ptr<ASTNode>&, Frame&);
+    bool evaluateCondition(const shared_ptr<ASTNode>&, Frame&);
+    void step();
+    static bool isBoolean(const shared_ptr<ASTNode>&);
+};
+
+#endif //INTERPRETER_HPP
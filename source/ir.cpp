@@ -0,0 +1,614 @@
+#include "ir.hpp"
+
+#include <algorithm>
+#include <functional>
+
+#include "optimizer.hpp"
+
+IROperand IROperand::constant(int value) {
+    IROperand operand;
+    operand.kind = Kind::CONSTANT;
+    operand.value = value;
+    return operand;
+}
+
+IROperand IROperand::variable(const string& name) {
+    IROperand operand;
+    operand.kind = Kind::VARIABLE;
+    operand.name = name;
+    return operand;
+}
+
+string IROperand::toString() const {
+    switch (kind) {
+        case Kind::CONSTANT: return to_string(value);
+        case Kind::VARIABLE: return version < 0 ? name : name + "." + to_string(version);
+        default: return "_";
+    }
+}
+
+bool IRInstruction::isTerminator() const {
+    return opcode == IROpcode::JUMP || opcode == IROpcode::BRANCH || opcode == IROpcode::RETURN;
+}
+
+vector<const IROperand*> IRInstruction::uses() const {
+    vector<const IROperand*> result;
+    for (const IROperand& operand : operands) {
+        if (operand.isVariable()) result.push_back(&operand);
+    }
+    return result;
+}
+
+vector<IROperand*> IRInstruction::usesMutable() {
+    vector<IROperand*> result;
+    for (IROperand& operand : operands) {
+        if (operand.isVariable()) result.push_back(&operand);
+    }
+    return result;
+}
+
+static string compareName(LogicalType type) {
+    switch (type) {
+        case LogicalType::EQUAL: return "eq";
+        case LogicalType::NOT_EQUAL: return "ne";
+        case LogicalType::LESS_THAN: return "lt";
+        case LogicalType::GREATER_THAN: return "gt";
+        case LogicalType::LESS_EQUAL: return "le";
+        case LogicalType::GREATER_EQUAL: return "ge";
+        default: throw runtime_error("IR: no compare");
+    }
+}
+
+string IRInstruction::toString() const {
+    auto operand = [&](int i) { return operands.at(i).toString(); };
+    auto list = [&](int from) {
+        string result;
+        for (int i = from; i < operands.size(); i++) {
+            result += (i > from ? ", " : "") + operand(i);
+        }
+        return result;
+    };
+    string target = dest.kind == IROperand::Kind::NONE ? "" : dest.toString() + " = ";
+
+    switch (opcode) {
+        case IROpcode::COPY: return target + operand(0);
+        case IROpcode::ADD: return target + "add " + operand(0) + ", " + operand(1);
+        case IROpcode::SUB: return target + "sub " + operand(0) + ", " + operand(1);
+        case IROpcode::MUL: return target + "mul " + operand(0) + ", " + operand(1);
+        case IROpcode::DIV: return target + "div " + operand(0) + ", " + operand(1);
+        case IROpcode::MOD: return target + "mod " + operand(0) + ", " + operand(1);
+        case IROpcode::AND: return target + "and " + operand(0) + ", " + operand(1);
+        case IROpcode::OR: return target + "or " + operand(0) + ", " + operand(1);
+        case IROpcode::NOT: return target + "not " + operand(0);
+        case IROpcode::COMPARE: return target + compareName(compare) + " " + operand(0) + ", " + operand(1);
+        case IROpcode::LOAD: return target + "load " + type.toString() + " " + operand(0) + "[" + operand(1) + "]";
+        case IROpcode::STORE: return "store " + type.toString() + " " + operand(0) + "[" + operand(1) + "], " + operand(2);
+        case IROpcode::DREF: return target + "dref " + type.toString() + " " + operand(0);
+        case IROpcode::SREF: return "sref " + type.toString() + " " + operand(0) + ", " + operand(1);
+        case IROpcode::LENGTH: return target + "length " + operand(0);
+        case IROpcode::ALLOCATE: return target + "allocate " + type.toString() + " " + operand(0) + (operands.size() > 1 ? " {" + list(1) + "}" : "");
+        case IROpcode::CALL: return target + (isTailCall ? "tailcall " : "call ") + callee + "(" + list(0) + ")";
+        case IROpcode::OUTPUT: return "output " + operand(0);
+        case IROpcode::PHI: {
+            string result = target + "phi ";
+            for (int i = 0; i < operands.size(); i++) {
+                result += (i > 0 ? ", " : "") + string("[") + operand(i) + ", bb" + to_string(blocks.at(i)) + "]";
+            }
+            return result;
+        }
+        case IROpcode::JUMP: return "jump bb" + to_string(blocks.at(0));
+        case IROpcode::BRANCH:
+            return "branch " + compareName(compare) + " " + operand(0) + ", " + operand(1) + ", bb" + to_string(blocks.at(0)) + ", bb" + to_string(blocks.at(1));
+        case IROpcode::RETURN: return operands.empty() ? "return" : "return " + operand(0);
+    }
+    return "";
+}
+
+vector<int> IRFunction::reversePostorder() const {
+    vector<int> order;
+    vector<bool> visited(blocks.size(), false);
+    function<void(int)> visit = [&](int block) {
+        visited[block] = true;
+        for (int successor : blocks.at(block).successors) {
+            if (!visited[successor]) visit(successor);
+        }
+        order.push_back(block);
+    };
+    visit(0);
+    reverse(order.begin(), order.end());
+    return order;
+}
+
+//successors from the terminators, no duplicates for branches with equal targets
+void IRFunction::computeEdges() {
+    for (BasicBlock& block : blocks) {
+        block.predecessors.clear();
+        block.successors.clear();
+    }
+    for (BasicBlock& block : blocks) {
+        if (block.instructions.empty() || !block.instructions.back().isTerminator()) {
+            continue;
+        }
+        for (int target : block.instructions.back().blocks) {
+            if (find(block.successors.begin(), block.successors.end(), target) == block.successors.end()) {
+                block.successors.push_back(target);
+                blocks.at(target).predecessors.push_back(block.id);
+            }
+        }
+    }
+}
+
+string IRFunction::toString() const {
+    string output = "function " + name + "(";
+    for (int i = 0; i < parameters.size(); i++) {
+        output += (i > 0 ? ", " : "") + parameters.at(i).first.toString() + " " + parameters.at(i).second;
+    }
+    output += ") " + returnType.toString() + (isSSA ? " ssa" : "") + "\n";
+
+    for (const BasicBlock& block : blocks) {
+        output += "bb" + to_string(block.id) + ":";
+        if (!block.label.empty()) {
+            output += " ; " + block.label;
+        }
+        if (!block.predecessors.empty()) {
+            output += " ; preds";
+            for (int predecessor : block.predecessors) {
+                output += " bb" + to_string(predecessor);
+            }
+        }
+        output += "\n";
+        for (const IRInstruction& instruction : block.instructions) {
+            output += "    " + instruction.toString() + "\n";
+        }
+    }
+    return output;
+}
+
+//backwards until no set changes, phi operands are live at the end of their predecessor
+Liveness computeLiveness(const IRFunction& function) {
+    int count = function.blocks.size();
+    vector<unordered_set<string>> uses(count);
+    vector<unordered_set<string>> definitions(count);
+    vector<unordered_map<int, unordered_set<string>>> phiUses(count); //predecessor -> operands
+    for (const BasicBlock& block : function.blocks) {
+        for (const IRInstruction& instruction : block.instructions) {
+            if (instruction.opcode == IROpcode::PHI) {
+                for (int i = 0; i < instruction.operands.size(); i++) {
+                    if (instruction.operands[i].isVariable()) phiUses[block.id][instruction.blocks[i]].insert(instruction.operands[i].toString());
+                }
+            }
+            else {
+                for (const IROperand* use : instruction.uses()) {
+                    if (!definitions[block.id].count(use->toString())) uses[block.id].insert(use->toString());
+                }
+            }
+            if (instruction.dest.isVariable()) {
+                definitions[block.id].insert(instruction.dest.toString());
+            }
+        }
+    }
+
+    Liveness liveness = {vector<unordered_set<string>>(count), vector<unordered_set<string>>(count)};
+    vector<int> order = function.reversePostorder();
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto it = order.rbegin(); it != order.rend(); it++) {
+            const BasicBlock& block = function.blocks.at(*it);
+            unordered_set<string> out;
+            for (int successor : block.successors) {
+                out.insert(liveness.liveIn[successor].begin(), liveness.liveIn[successor].end());
+                if (phiUses[successor].count(block.id)) {
+                    out.insert(phiUses[successor].at(block.id).begin(), phiUses[successor].at(block.id).end());
+                }
+            }
+            unordered_set<string> in = uses[block.id];
+            for (const string& name : out) {
+                if (!definitions[block.id].count(name)) in.insert(name);
+            }
+            if (in != liveness.liveIn[block.id] || out != liveness.liveOut[block.id]) {
+                liveness.liveIn[block.id] = in;
+                liveness.liveOut[block.id] = out;
+                changed = true;
+            }
+        }
+    }
+    return liveness;
+}
+
+bool isLocalIRVariable(const string& name) {
+    return !isMemoryAlias(name) && !SKIP_IDENT_NAMES.count(name);
+}
+
+IRBuilder::IRBuilder(const vector<FunctionDescr>& function_descrs, const unordered_map<string, Type>& variables)
+    : function_descrs(function_descrs), variables(variables) {}
+
+IRFunction IRBuilder::build(const shared_ptr<FunctionDefinitionNode>& definition) {
+    function = IRFunction();
+    function.name = findFunctionDescr(definition, function_descrs).address;
+    function.returnType = definition->returnType;
+    function.parameters = definition->parameters;
+    function.variables = variables;
+    temporaryNum = 0;
+    labelBlocks.clear();
+
+    layout.clear();
+    setCurrent(newBlock());
+    lowerBlock(definition->body);
+    if (!isTerminated()) {
+        emit({IROpcode::RETURN});
+    }
+
+    removeUnreachableBlocks();
+    return function;
+}
+
+int IRBuilder::newBlock() {
+    int id = function.blocks.size();
+    function.blocks.push_back({id, "", {}, {}, {}});
+    return id;
+}
+
+int IRBuilder::getLabelBlock(const string& label) {
+    if (!labelBlocks.count(label)) {
+        labelBlocks[label] = newBlock();
+        function.blocks.at(labelBlocks.at(label)).label = label;
+    }
+    return labelBlocks.at(label);
+}
+
+//falls through from the current block
+void IRBuilder::startBlock(int block) {
+    if (!isTerminated()) {
+        IRInstruction jump = {IROpcode::JUMP};
+        jump.blocks = {block};
+        emit(jump);
+    }
+    setCurrent(block);
+}
+
+void IRBuilder::setCurrent(int block) {
+    current = block;
+    if (find(layout.begin(), layout.end(), block) == layout.end()) {
+        layout.push_back(block);
+    }
+}
+
+bool IRBuilder::isTerminated() const {
+    const vector<IRInstruction>& instructions = function.blocks.at(current).instructions;
+    return !instructions.empty() && instructions.back().isTerminator();
+}
+
+void IRBuilder::emit(IRInstruction instruction) {
+    //code behind return/goto gets a block without predecessors
+    if (isTerminated()) {
+        setCurrent(newBlock());
+    }
+    instruction.statement = statement;
+    function.blocks.at(current).instructions.push_back(instruction);
+}
+
+IROperand IRBuilder::newTemporary(const Type& type) {
+    string name = "$" + to_string(temporaryNum++);
+    function.variables[name] = type;
+    return IROperand::variable(name);
+}
+
+void IRBuilder::lowerBlock(const vector<shared_ptr<ASTNode>>& block) {
+    for (const shared_ptr<ASTNode>& node : block) {
+        statement = node.get();
+        lowerStatement(node);
+    }
+}
+
+void IRBuilder::lowerStatement(const shared_ptr<ASTNode>& node) {
+    if (auto x = dynamic_pointer_cast<VariableDeclarationNode>(node)) {
+        if (x->value != nullptr) {
+            lowerStore(make_shared<IdentifierNode>(x->varName), x->value);
+        }
+    }
+    else if (auto x = dynamic_pointer_cast<AssignmentNode>(node)) {
+        lowerStore(x->variable, x->expression);
+    }
+    else if (auto x = dynamic_pointer_cast<ArrayDeclarationNode>(node)) {
+        IRInstruction allocate = {IROpcode::ALLOCATE, IROperand::variable(x->name)};
+        allocate.type = convertArrayToVarType(x->type);
+        allocate.operands.push_back(IROperand::constant(x->size == -1 ? x->arrayValues.size() : x->size));
+        for (const auto& value : x->arrayValues) {
+            allocate.operands.push_back(lowerExpression(value, allocate.type));
+        }
+        emit(allocate);
+    }
+    else if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        lowerCall(x, false);
+    }
+    else if (auto x = dynamic_pointer_cast<ReturnValueNode>(node)) {
+        IRInstruction ret = {IROpcode::RETURN};
+        ret.operands.push_back(lowerExpression(x->value, function.returnType));
+        emit(ret);
+    }
+    else if (dynamic_pointer_cast<ReturnNode>(node)) {
+        emit({IROpcode::RETURN});
+    }
+    else if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+        int thenBlock = newBlock();
+        int elseBlock = x->elseBlock.empty() ? -1 : newBlock();
+        int endBlock = newBlock();
+        lowerCondition(x->condition, thenBlock, elseBlock == -1 ? endBlock : elseBlock);
+        startBlock(thenBlock);
+        lowerBlock(x->thenBlock);
+        if (elseBlock != -1) {
+            startBlock(endBlock);
+            setCurrent(elseBlock);
+            lowerBlock(x->elseBlock);
+        }
+        startBlock(endBlock);
+    }
+    else if (auto x = dynamic_pointer_cast<LabelNode>(node)) {
+        startBlock(getLabelBlock(x->label));
+    }
+    else if (auto x = dynamic_pointer_cast<GotoNode>(node)) {
+        IRInstruction jump = {IROpcode::JUMP};
+        jump.blocks = {getLabelBlock(x->label)};
+        emit(jump);
+    }
+    else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+        lowerBlock(x->body);
+    }
+    else if (dynamic_pointer_cast<WhileNode>(node) || dynamic_pointer_cast<ForNode>(node)) {
+        throw runtime_error("IR: loops have to be rewritten first");
+    }
+}
+
+void IRBuilder::lowerStore(const shared_ptr<IdentifierNode>& target, const shared_ptr<ASTNode>& value) {
+    const string& name = target->name;
+    if (SKIP_IDENT_NAMES.count(name)) {
+        emit({IROpcode::COPY, IROperand::variable(name), {lowerExpression(value, Type(TypeType::INT))}});
+        return;
+    }
+
+    Type type = function.variables.at(name);
+    if (isMemoryAlias(name)) {
+        IRInstruction store = {IROpcode::SREF, {}, {IROperand::variable(name.substr(1)), lowerExpression(value, type)}};
+        store.type = type;
+        emit(store);
+        return;
+    }
+    if (target->index != nullptr) {
+        Type elementType = convertArrayToVarType(type);
+        IROperand index = lowerExpression(target->index, Type(TypeType::INT));
+        IRInstruction store = {IROpcode::STORE, {}, {IROperand::variable(name), index, lowerExpression(value, elementType)}};
+        store.type = elementType;
+        emit(store);
+        return;
+    }
+
+    IROperand result = lowerExpression(value, type);
+    //x = a + b: the temporary of the last instruction becomes x
+    vector<IRInstruction>& instructions = function.blocks.at(current).instructions;
+    if (result.isVariable() && result.name[0] == '$' && function.variables.at(result.name).getEnum() == type.getEnum()
+        && !instructions.empty() && instructions.back().dest.name == result.name) {
+        instructions.back().dest = IROperand::variable(name);
+        function.variables.erase(result.name);
+        return;
+    }
+    IRInstruction copy = {IROpcode::COPY, IROperand::variable(name), {result}};
+    copy.type = type;
+    emit(copy);
+}
+
+//expected types are the ones the generator evaluates the expression with
+IROperand IRBuilder::lowerExpression(const shared_ptr<ASTNode>& node, const Type& expected_type) {
+    if (auto x = dynamic_pointer_cast<NumberNode>(node)) {
+        return IROperand::constant(x->value);
+    }
+    if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+        if (SKIP_IDENT_NAMES.count(x->name)) {
+            return IROperand::variable(x->name);
+        }
+        Type type = function.variables.at(x->name);
+        if (isMemoryAlias(x->name)) {
+            IROperand result = newTemporary(type);
+            IRInstruction load = {IROpcode::DREF, result, {IROperand::variable(x->name.substr(1))}};
+            load.type = type;
+            emit(load);
+            return result;
+        }
+        if (x->index != nullptr) {
+            Type elementType = convertArrayToVarType(type);
+            IROperand index = lowerExpression(x->index, Type(TypeType::INT));
+            IROperand result = newTemporary(elementType);
+            IRInstruction load = {IROpcode::LOAD, result, {IROperand::variable(x->name), index}};
+            load.type = elementType;
+            emit(load);
+            return result;
+        }
+        return IROperand::variable(x->name);
+    }
+    if (auto x = dynamic_pointer_cast<ArithmeticNode>(node)) {
+        IROperand left = lowerExpression(x->left, expected_type);
+        IROperand right = lowerExpression(x->right, expected_type);
+        IROpcode opcode;
+        switch (x->arithmeticType) {
+            case ArithmeticType::ADD: opcode = IROpcode::ADD; break;
+            case ArithmeticType::SUBTRACT: opcode = IROpcode::SUB; break;
+            case ArithmeticType::MULTIPLY: opcode = IROpcode::MUL; break;
+            case ArithmeticType::DIVIDE: opcode = IROpcode::DIV; break;
+            default: opcode = IROpcode::MOD; break;
+        }
+        IROperand result = newTemporary(expected_type);
+        IRInstruction instruction = {opcode, result, {left, right}};
+        instruction.type = expected_type;
+        emit(instruction);
+        return result;
+    }
+    if (auto x = dynamic_pointer_cast<LogicalNode>(node)) {
+        IROperand left = lowerExpression(x->left, Type(TypeType::INT));
+        IROperand right = lowerExpression(x->right, Type(TypeType::INT));
+        IROperand result = newTemporary(Type(TypeType::INT));
+        IRInstruction instruction = {IROpcode::COMPARE, result, {left, right}};
+        if (x->logicalType == LogicalType::AND) instruction.opcode = IROpcode::AND;
+        else if (x->logicalType == LogicalType::OR) instruction.opcode = IROpcode::OR;
+        else instruction.compare = x->logicalType;
+        instruction.type = Type(TypeType::INT);
+        emit(instruction);
+        return result;
+    }
+    if (auto x = dynamic_pointer_cast<LogicalNotNode>(node)) {
+        IROperand operand = lowerExpression(x->operand, Type(TypeType::INT));
+        IROperand result = newTemporary(Type(TypeType::INT));
+        IRInstruction instruction = {IROpcode::NOT, result, {operand}};
+        instruction.type = Type(TypeType::INT);
+        emit(instruction);
+        return result;
+    }
+    if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        return lowerCall(x, true);
+    }
+    throw runtime_error("IR: unsupported expression");
+}
+
+IROperand IRBuilder::lowerCall(const shared_ptr<FunctionCallNode>& call, bool needsResult) {
+    const string& name = call->functionName;
+    if (name == OUTPUT_FUNCTION) {
+        emit({IROpcode::OUTPUT, {}, {lowerExpression(call->arguments.at(0), Type(TypeType::INT))}});
+        return {};
+    }
+    if (name == LENGTH_FUNCTION) {
+        auto array = dynamic_pointer_cast<IdentifierNode>(call->arguments.at(0));
+        IROperand result = newTemporary(Type(TypeType::INT));
+        IRInstruction length = {IROpcode::LENGTH, result, {IROperand::variable(array->name)}};
+        length.type = Type(TypeType::INT);
+        emit(length);
+        return result;
+    }
+    if (name == DREF_FUNCTION) {
+        IROperand address = lowerExpression(call->arguments.at(0), Type(TypeType::INT));
+        IROperand result = newTemporary(Type(TypeType::INT));
+        IRInstruction load = {IROpcode::DREF, result, {address}};
+        load.type = Type(TypeType::INT);
+        emit(load);
+        return result;
+    }
+    if (name == SREF_FUNCTION) {
+        //the second argument is a variable, its type is the stored width
+        auto value = dynamic_pointer_cast<IdentifierNode>(call->arguments.at(1));
+        Type type = SKIP_IDENT_NAMES.count(value->name) ? Type(TypeType::INT) : convertArrayToVarType(function.variables.at(value->name));
+        IROperand address = lowerExpression(call->arguments.at(0), Type(TypeType::INT));
+        IRInstruction store = {IROpcode::SREF, {}, {address, lowerExpression(value, type)}};
+        store.type = type;
+        emit(store);
+        return {};
+    }
+
+    FunctionDescr descr = findCallDescr(call, variables, function_descrs);
+    IRInstruction instruction = {IROpcode::CALL};
+    for (int i = 0; i < call->arguments.size(); i++) {
+        instruction.operands.push_back(lowerExpression(call->arguments.at(i), descr.params.at(i).second));
+    }
+    if (needsResult && descr.type.getEnum() != TypeType::VOID) {
+        instruction.dest = newTemporary(descr.type);
+    }
+    instruction.type = descr.type;
+    instruction.callee = descr.address;
+    instruction.isTailCall = call->isTailCall;
+    emit(instruction);
+    return instruction.dest;
+}
+
+//short circuit only where the generator does it, other values are compared with 0
+void IRBuilder::lowerCondition(const shared_ptr<ASTNode>& node, int trueBlock, int falseBlock) {
+    if (auto x = dynamic_pointer_cast<LogicalNotNode>(node)) {
+        lowerCondition(x->operand, falseBlock, trueBlock);
+        return;
+    }
+
+    IRInstruction branch = {IROpcode::BRANCH};
+    branch.blocks = {trueBlock, falseBlock};
+    auto x = dynamic_pointer_cast<LogicalNode>(node);
+    if (x && (x->logicalType == LogicalType::AND || x->logicalType == LogicalType::OR)) {
+        if (isBooleanCondition(x->left) && isBooleanCondition(x->right) && !containsCall(x->right)) {
+            int rightBlock = newBlock();
+            if (x->logicalType == LogicalType::AND) {
+                lowerCondition(x->left, rightBlock, falseBlock);
+            }
+            else {
+                lowerCondition(x->left, trueBlock, rightBlock);
+            }
+            setCurrent(rightBlock);
+            lowerCondition(x->right, trueBlock, falseBlock);
+            return;
+        }
+    }
+    else if (x) {
+        branch.operands = {lowerExpression(x->left, Type(TypeType::INT)), lowerExpression(x->right, Type(TypeType::INT))};
+        branch.compare = x->logicalType;
+        emit(branch);
+        return;
+    }
+
+    branch.operands = {lowerExpression(node, Type(TypeType::INT)), IROperand::constant(0)};
+    branch.compare = LogicalType::NOT_EQUAL;
+    emit(branch);
+}
+
+//drops blocks without a path from the entry and numbers the rest in the order of the AST
+void IRBuilder::removeUnreachableBlocks() {
+    function.computeEdges();
+    vector<bool> reachable(function.blocks.size(), false);
+    vector<int> worklist = {0};
+    reachable[0] = true;
+    while (!worklist.empty()) {
+        int block = worklist.back();
+        worklist.pop_back();
+        for (int successor : function.blocks.at(block).successors) {
+            if (!reachable[successor]) {
+                reachable[successor] = true;
+                worklist.push_back(successor);
+            }
+        }
+    }
+
+    vector<int> newId(function.blocks.size(), -1);
+    vector<BasicBlock> blocks;
+    for (int id : layout) {
+        if (reachable[id]) {
+            BasicBlock& block = function.blocks.at(id);
+            newId[id] = blocks.size();
+            block.id = blocks.size();
+            blocks.push_back(block);
+        }
+    }
+    for (BasicBlock& block : blocks) {
+        if (block.instructions.empty()) {
+            throw runtime_error("IR: block without terminator");
+        }
+        for (int& target : block.instructions.back().blocks) {
+            target = newId[target];
+        }
+    }
+    function.blocks = blocks;
+    function.computeEdges();
+}
+
+bool IRBuilder::isBooleanCondition(const shared_ptr<ASTNode>& node) {
+    if (dynamic_pointer_cast<LogicalNotNode>(node)) {
+        return true;
+    }
+    if (auto x = dynamic_pointer_cast<LogicalNode>(node)) {
+        if (x->logicalType == LogicalType::AND || x->logicalType == LogicalType::OR) {
+            return isBooleanCondition(x->left) && isBooleanCondition(x->right);
+        }
+        return true;
+    }
+    return false;
+}
+
+bool IRBuilder::containsCall(const shared_ptr<ASTNode>& node) {
+    bool found = false;
+    visitNodes(node, [&](const shared_ptr<ASTNode>& x) {
+        auto call = dynamic_pointer_cast<FunctionCallNode>(x);
+        if (call && call->functionName != LENGTH_FUNCTION && call->functionName != DREF_FUNCTION) found = true;
+    });
+    return found;
+}
@@ -0,0 +1,139 @@
+#ifndef IR_HPP
+#define IR_HPP
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ast.h"
+#include "analyzer.hpp"
+
+using namespace std;
+
+//three address code in basic blocks, built from the rewritten AST (loops are labels, gotos and ifs)
+enum class IROpcode {
+    COPY,       // d = a
+    ADD,        // d = a + b
+    SUB,
+    MUL,
+    DIV,
+    MOD,
+    AND,        // bitwise like the generated code for && / || on values
+    OR,
+    NOT,        // d = a == 0
+    COMPARE,    // d = a <compare> b, 0 or 1
+    LOAD,       // d = a[b]
+    STORE,      // a[b] = c
+    DREF,       // d = memory[a]
+    SREF,       // memory[a] = b
+    LENGTH,     // d = length of array a
+    ALLOCATE,   // d = new array of a elements, initialized with the remaining operands
+    CALL,       // d = callee(operands), d empty for void calls
+    OUTPUT,     // @output(a)
+    PHI,        // d = phi(operands), one per predecessor in blocks
+    JUMP,       // goto blocks[0]
+    BRANCH,     // if (a <compare> b) goto blocks[0] else goto blocks[1]
+    RETURN,     // return a, no operand for void functions
+};
+
+struct IROperand {
+    enum class Kind { NONE, CONSTANT, VARIABLE };
+    Kind kind = Kind::NONE;
+    int value = 0;
+    string name;
+    int version = -1; //SSA version, -1 outside of SSA form
+
+    static IROperand constant(int value);
+    static IROperand variable(const string& name);
+    bool isConstant() const { return kind == Kind::CONSTANT; }
+    bool isVariable() const { return kind == Kind::VARIABLE; }
+    string toString() const;
+};
+
+struct IRInstruction {
+    IROpcode opcode;
+    IROperand dest;
+    vector<IROperand> operands;
+    Type type; //of the result, of the stored value for STORE/SREF
+    LogicalType compare = LogicalType::EQUAL;
+    string callee; //function address
+    bool isTailCall = false;
+    vector<int> blocks; //jump targets, predecessors of PHI operands
+    const ASTNode* statement = nullptr; //AST statement the instruction was lowered from
+
+    bool isTerminator() const;
+    //variables read / written, SREF/STORE write memory only
+    vector<const IROperand*> uses() const;
+    vector<IROperand*> usesMutable();
+    string toString() const;
+};
+
+struct BasicBlock {
+    int id;
+    string label; //AST label that starts the block, if any
+    vector<IRInstruction> instructions;
+    vector<int> predecessors;
+    vector<int> successors;
+};
+
+struct IRFunction {
+    string name; //function address
+    Type returnType;
+    vector<pair<Type, string>> parameters;
+    unordered_map<string, Type> variables; //including IR temporaries
+    vector<BasicBlock> blocks; //blocks[0] is the entry
+    bool isSSA = false;
+
+    //blocks reachable from the entry in reverse postorder
+    vector<int> reversePostorder() const;
+    void computeEdges();
+    string toString() const;
+};
+
+//variables (with SSA version) live at the start and the end of each block
+struct Liveness {
+    vector<unordered_set<string>> liveIn;
+    vector<unordered_set<string>> liveOut;
+};
+Liveness computeLiveness(const IRFunction&);
+
+//variables of the function that live in the frame and can be renamed, not @HP/@FREE or '*p' memory
+bool isLocalIRVariable(const string& name);
+
+class IRBuilder {
+public:
+    IRBuilder(const vector<FunctionDescr>&, const unordered_map<string, Type>& variables);
+    IRFunction build(const shared_ptr<FunctionDefinitionNode>&);
+
+private:
+    const vector<FunctionDescr>& function_descrs;
+    const unordered_map<string, Type>& variables;
+    IRFunction function;
+    int current = 0;
+    int temporaryNum = 0;
+    unordered_map<string, int> labelBlocks;
+    vector<int> layout; //blocks in the order their code appears
+    const ASTNode* statement = nullptr;
+
+    int newBlock();
+    int getLabelBlock(const string& label);
+    void startBlock(int block);
+    void setCurrent(int block);
+    bool isTerminated() const;
+    void emit(IRInstruction);
+    IROperand newTemporary(const Type&);
+
+    void lowerBlock(const vector<shared_ptr<ASTNode>>&);
+    void lowerStatement(const shared_ptr<ASTNode>&);
+    void lowerStore(const shared_ptr<IdentifierNode>& target, const shared_ptr<ASTNode>& value);
+    IROperand lowerExpression(const shared_ptr<ASTNode>&, const Type& expected_type);
+    IROperand lowerCall(const shared_ptr<FunctionCallNode>&, bool needsResult);
+    void lowerCondition(const shared_ptr<ASTNode>&, int trueBlock, int falseBlock);
+    void removeUnreachableBlocks();
+    static bool isBooleanCondition(const shared_ptr<ASTNode>&);
+    static bool containsCall(const shared_ptr<ASTNode>&);
+};
+
+#endif //IR_HPP
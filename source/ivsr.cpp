@@ -0,0 +1,325 @@
+#include "ivsr.hpp"
+
+InductionVariableStrengthReduction::InductionVariableStrengthReduction(OptimizerContext& context) : context(context) {}
+
+void InductionVariableStrengthReduction::run(const shared_ptr<FunctionDefinitionNode>& function) {
+    this->function = function;
+    processBlock(function->body);
+}
+
+const unordered_map<string, Type>& InductionVariableStrengthReduction::variables() {
+    return context.variables.at(function->functionName);
+}
+
+void InductionVariableStrengthReduction::processBlock(vector<shared_ptr<ASTNode>>& block) {
+    for (shared_ptr<ASTNode>& node : block) {
+        if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+            reduceLoop(x);
+            processBlock(x->body);
+        }
+        else if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+            processBlock(x->body);
+        }
+        else if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+            processBlock(x->thenBlock);
+            processBlock(x->elseBlock);
+        }
+        else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+            processBlock(x->body);
+        }
+    }
+}
+
+void InductionVariableStrengthReduction::reduceLoop(const shared_ptr<ForNode>& loop) {
+    //int i = a; ...; i = i + c
+    auto init = dynamic_pointer_cast<VariableDeclarationNode>(loop->init);
+    if (init == nullptr || init->varType.getEnum() != TypeType::INT) {
+        return;
+    }
+    counter = init->varName;
+    int step = getCounterStep(loop->update, counter);
+    if (step == 0) {
+        return;
+    }
+
+    loopEffects = SideEffects();
+    collectSideEffects(static_pointer_cast<ASTNode>(loop), loopEffects);
+    SideEffects bodyEffects;
+    collectSideEffects(loop->body, bodyEffects);
+    if (loopEffects.hasLabel || bodyEffects.writtenVariables.count(counter)) {
+        return;
+    }
+
+    accessCount.clear();
+    accessOrder.clear();
+    otherCounterUses = 0;
+    for (const auto& stmt : loop->body) {
+        scanStatement(stmt);
+    }
+
+    //i < n with invariant n can become a pointer compare
+    shared_ptr<LogicalNode> compare = dynamic_pointer_cast<LogicalNode>(loop->condition);
+    shared_ptr<ASTNode> bound;
+    bool counterLeft = false;
+    if (compare && compare->logicalType != LogicalType::AND && compare->logicalType != LogicalType::OR) {
+        auto compareLeft = dynamic_pointer_cast<IdentifierNode>(compare->left);
+        auto compareRight = dynamic_pointer_cast<IdentifierNode>(compare->right);
+        if (compareLeft && compareLeft->name == counter && compareLeft->index == nullptr && isLoopInvariant(compare->right)) {
+            bound = compare->right;
+            counterLeft = true;
+        }
+        else if (compareRight && compareRight->name == counter && compareRight->index == nullptr && isLoopInvariant(compare->left)) {
+            bound = compare->left;
+        }
+    }
+    if (bound == nullptr) {
+        scanExpression(loop->condition);
+    }
+
+    if (accessCount.empty()) {
+        return;
+    }
+
+    unordered_set<string> outsideReads;
+    for (const auto& stmt : function->body) {
+        collectStatementReads(stmt, outsideReads, loop.get());
+    }
+    bool removeCounter = bound != nullptr && otherCounterUses == 0 && !outsideReads.count(counter);
+
+    //profitability: index computations saved against pointer increments added
+    int accesses = 0;
+    for (const auto& [array, count] : accessCount) {
+        accesses += count;
+    }
+    int savings = accesses * INDEX_COST + (removeCounter ? INCREMENT_COST : 0);
+    int cost = static_cast<int>(accessCount.size()) * INCREMENT_COST;
+    if (savings <= cost) {
+        return;
+    }
+
+    if (loop->guard == nullptr) {
+        loop->guard = cloneNode(loop->condition);
+    }
+
+    //pointers start at the element of the initial counter value
+    shared_ptr<ASTNode> start = dynamic_pointer_cast<NumberNode>(init->value) ? init->value : make_shared<IdentifierNode>(counter);
+    vector<shared_ptr<ASTNode>> increments;
+    aliases.clear();
+    for (const string& array : accessOrder) {
+        Type elementType = convertArrayToVarType(variables().at(array));
+        string pointer = context.newTemporary(function->functionName, "iv", Type(TypeType::INT));
+        aliases[array] = context.newMemoryAlias(function->functionName, pointer, elementType);
+
+        loop->preheader.push_back(make_shared<AssignmentNode>(make_shared<IdentifierNode>(pointer), elementAddress(array, start)));
+        increments.push_back(make_shared<AssignmentNode>(make_shared<IdentifierNode>(pointer),
+            make_shared<ArithmeticNode>(ArithmeticType::ADD, make_shared<IdentifierNode>(pointer), make_shared<NumberNode>(step * elementType.size()))));
+    }
+
+    for (const auto& stmt : loop->body) {
+        replaceStatement(stmt);
+    }
+
+    if (removeCounter) {
+        //i < n => p < &arr[n]
+        string pointer = aliases.at(accessOrder.front()).substr(1);
+        string end = context.newTemporary(function->functionName, "iv", Type(TypeType::INT));
+        loop->preheader.push_back(make_shared<AssignmentNode>(make_shared<IdentifierNode>(end), elementAddress(accessOrder.front(), bound)));
+
+        compare->left = make_shared<IdentifierNode>(counterLeft ? pointer : end);
+        compare->right = make_shared<IdentifierNode>(counterLeft ? end : pointer);
+    }
+    else {
+        loop->condition = replaceExpression(loop->condition);
+        increments.insert(increments.begin(), loop->update);
+    }
+    loop->update = make_shared<BlockNode>(increments);
+}
+
+//array variable indexed exactly by the counter
+bool InductionVariableStrengthReduction::isReducible(const shared_ptr<IdentifierNode>& identifier) {
+    auto index = dynamic_pointer_cast<IdentifierNode>(identifier->index);
+    if (index == nullptr || index->name != counter || index->index != nullptr) {
+        return false;
+    }
+    auto it = variables().find(identifier->name);
+    return it != variables().end() && it->second.isArray() && !loopEffects.writtenVariables.count(identifier->name);
+}
+
+bool InductionVariableStrengthReduction::isLoopInvariant(const shared_ptr<ASTNode>& node) {
+    if (dynamic_pointer_cast<NumberNode>(node)) {
+        return true;
+    }
+    if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+        if (x->index != nullptr || isMemoryAlias(x->name)) {
+            return false;
+        }
+        if (SKIP_IDENT_NAMES.count(x->name) && loopEffects.writesMemory) {
+            return false;
+        }
+        return !loopEffects.writtenVariables.count(x->name);
+    }
+    return false;
+}
+
+void InductionVariableStrengthReduction::scanStatement(const shared_ptr<ASTNode>& node) {
+    if (node == nullptr) {
+        return;
+    }
+    if (auto x = dynamic_pointer_cast<VariableDeclarationNode>(node)) {
+        scanExpression(x->value);
+    }
+    else if (auto x = dynamic_pointer_cast<AssignmentNode>(node)) {
+        if (x->variable->index != nullptr) {
+            scanExpression(x->variable);
+        }
+        scanExpression(x->expression);
+    }
+    else if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        scanExpression(x);
+    }
+    else if (auto x = dynamic_pointer_cast<ReturnValueNode>(node)) {
+        scanExpression(x->value);
+    }
+    else if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+        scanExpression(x->condition);
+        for (const auto& stmt : x->thenBlock) scanStatement(stmt);
+        for (const auto& stmt : x->elseBlock) scanStatement(stmt);
+    }
+    else if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+        scanExpression(x->condition);
+        scanExpression(x->guard);
+        for (const auto& stmt : x->preheader) scanStatement(stmt);
+        for (const auto& stmt : x->body) scanStatement(stmt);
+    }
+    else if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+        scanStatement(x->init);
+        scanExpression(x->condition);
+        scanExpression(x->guard);
+        scanStatement(x->update);
+        for (const auto& stmt : x->preheader) scanStatement(stmt);
+        for (const auto& stmt : x->body) scanStatement(stmt);
+    }
+    else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+        for (const auto& stmt : x->body) scanStatement(stmt);
+    }
+    else if (auto x = dynamic_pointer_cast<ArrayDeclarationNode>(node)) {
+        for (const auto& value : x->arrayValues) scanExpression(value);
+    }
+}
+
+void InductionVariableStrengthReduction::scanExpression(const shared_ptr<ASTNode>& node) {
+    if (node == nullptr) {
+        return;
+    }
+    if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+        if (isReducible(x)) {
+            if (accessCount[x->name]++ == 0) {
+                accessOrder.push_back(x->name);
+            }
+            return;
+        }
+        if (x->name == counter) {
+            otherCounterUses++;
+        }
+        scanExpression(x->index);
+    }
+    else if (auto x = dynamic_pointer_cast<ArithmeticNode>(node)) {
+        scanExpression(x->left);
+        scanExpression(x->right);
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNode>(node)) {
+        scanExpression(x->left);
+        scanExpression(x->right);
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNotNode>(node)) {
+        scanExpression(x->operand);
+    }
+    else if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        for (const auto& argument : x->arguments) scanExpression(argument);
+    }
+}
+
+void InductionVariableStrengthReduction::replaceStatement(const shared_ptr<ASTNode>& node) {
+    if (node == nullptr) {
+        return;
+    }
+    if (auto x = dynamic_pointer_cast<VariableDeclarationNode>(node)) {
+        x->value = replaceExpression(x->value);
+    }
+    else if (auto x = dynamic_pointer_cast<AssignmentNode>(node)) {
+        if (x->variable->index != nullptr) {
+            x->variable = static_pointer_cast<IdentifierNode>(replaceExpression(x->variable));
+        }
+        x->expression = replaceExpression(x->expression);
+    }
+    else if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        replaceExpression(x);
+    }
+    else if (auto x = dynamic_pointer_cast<ReturnValueNode>(node)) {
+        x->value = replaceExpression(x->value);
+    }
+    else if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+        x->condition = replaceExpression(x->condition);
+        for (const auto& stmt : x->thenBlock) replaceStatement(stmt);
+        for (const auto& stmt : x->elseBlock) replaceStatement(stmt);
+    }
+    else if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+        x->condition = replaceExpression(x->condition);
+        x->guard = replaceExpression(x->guard);
+        for (const auto& stmt : x->preheader) replaceStatement(stmt);
+        for (const auto& stmt : x->body) replaceStatement(stmt);
+    }
+    else if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+        replaceStatement(x->init);
+        x->condition = replaceExpression(x->condition);
+        x->guard = replaceExpression(x->guard);
+        replaceStatement(x->update);
+        for (const auto& stmt : x->preheader) replaceStatement(stmt);
+        for (const auto& stmt : x->body) replaceStatement(stmt);
+    }
+    else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+        for (const auto& stmt : x->body) replaceStatement(stmt);
+    }
+    else if (auto x = dynamic_pointer_cast<ArrayDeclarationNode>(node)) {
+        for (auto& value : x->arrayValues) value = replaceExpression(value);
+    }
+}
+
+shared_ptr<ASTNode> InductionVariableStrengthReduction::replaceExpression(const shared_ptr<ASTNode>& node) {
+    if (node == nullptr) {
+        return node;
+    }
+    if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+        if (isReducible(x) && aliases.count(x->name)) {
+            return make_shared<IdentifierNode>(aliases.at(x->name));
+        }
+        x->index = replaceExpression(x->index);
+    }
+    else if (auto x = dynamic_pointer_cast<ArithmeticNode>(node)) {
+        x->left = replaceExpression(x->left);
+        x->right = replaceExpression(x->right);
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNode>(node)) {
+        x->left = replaceExpression(x->left);
+        x->right = replaceExpression(x->right);
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNotNode>(node)) {
+        x->operand = replaceExpression(x->operand);
+    }
+    else if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        for (auto& argument : x->arguments) argument = replaceExpression(argument);
+    }
+    return node;
+}
+
+//address of array[index]: array + index * size + descriptor
+shared_ptr<ASTNode> InductionVariableStrengthReduction::elementAddress(const string& array, const shared_ptr<ASTNode>& index) {
+    int elementSize = convertArrayToVarType(variables().at(array)).size();
+    if (auto number = dynamic_pointer_cast<NumberNode>(index)) {
+        return make_shared<ArithmeticNode>(ArithmeticType::ADD, make_shared<IdentifierNode>(array), make_shared<NumberNode>(number->value * elementSize + 4));
+    }
+    return make_shared<ArithmeticNode>(ArithmeticType::ADD, make_shared<IdentifierNode>(array),
+        make_shared<ArithmeticNode>(ArithmeticType::ADD,
+            make_shared<ArithmeticNode>(ArithmeticType::MULTIPLY, cloneNode(index), make_shared<NumberNode>(elementSize)),
+            make_shared<NumberNode>(4)));
+}
@@ -0,0 +1,39 @@
+#ifndef IVSR_HPP
+#define IVSR_HPP
+
+#include "optimizer.hpp"
+
+//for (int i = a; i < n; i = i + c) { ... arr[i] ... } => pointer per array that advances by c * element size
+class InductionVariableStrengthReduction {
+public:
+    explicit InductionVariableStrengthReduction(OptimizerContext&);
+    void run(const shared_ptr<FunctionDefinitionNode>&);
+
+private:
+    //estimated MI instructions of Function::generateArrayIndex (MULT, ADD) and of a pointer 'p = p + c',
+    //one ADD in place plus the register the pointer takes
+    static const int INDEX_COST = 2;
+    static const int INCREMENT_COST = 2;
+
+    OptimizerContext& context;
+    shared_ptr<FunctionDefinitionNode> function;
+    string counter;
+    SideEffects loopEffects;
+    unordered_map<string, int> accessCount;
+    vector<string> accessOrder;
+    int otherCounterUses = 0;
+    unordered_map<string, string> aliases; //array -> '*pointer'
+
+    void processBlock(vector<shared_ptr<ASTNode>>&);
+    void reduceLoop(const shared_ptr<ForNode>&);
+    bool isReducible(const shared_ptr<IdentifierNode>&);
+    bool isLoopInvariant(const shared_ptr<ASTNode>&);
+    void scanStatement(const shared_ptr<ASTNode>&);
+    void scanExpression(const shared_ptr<ASTNode>&);
+    void replaceStatement(const shared_ptr<ASTNode>&);
+    shared_ptr<ASTNode> replaceExpression(const shared_ptr<ASTNode>&);
+    shared_ptr<ASTNode> elementAddress(const string& array, const shared_ptr<ASTNode>& index);
+    const unordered_map<string, Type>& variables();
+};
+
+#endif //IVSR_HPP
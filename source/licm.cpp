@@ -0,0 +1,253 @@
+#include "licm.hpp"
+
+LoopInvariantCodeMotion::LoopInvariantCodeMotion(OptimizerContext& context) : context(context) {}
+
+void LoopInvariantCodeMotion::run(const shared_ptr<FunctionDefinitionNode>& function) {
+    functionName = function->functionName;
+    returnType = function->returnType;
+    processBlock(function->body);
+}
+
+const unordered_map<string, Type>& LoopInvariantCodeMotion::variables() {
+    return context.variables.at(functionName);
+}
+
+//outer loops first, so expressions leave the whole loop nest if possible
+void LoopInvariantCodeMotion::processBlock(vector<shared_ptr<ASTNode>>& block) {
+    for (shared_ptr<ASTNode>& node : block) {
+        if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+            processLoop(node, x->condition, nullptr, x->body, x->preheader, x->guard);
+            processBlock(x->body);
+        }
+        else if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+            processLoop(node, x->condition, &x->update, x->body, x->preheader, x->guard);
+            processBlock(x->body);
+        }
+        else if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+            processBlock(x->thenBlock);
+            processBlock(x->elseBlock);
+        }
+        else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+            processBlock(x->body);
+        }
+    }
+}
+
+void LoopInvariantCodeMotion::processLoop(shared_ptr<ASTNode>& loop, shared_ptr<ASTNode>& condition, shared_ptr<ASTNode>* update, vector<shared_ptr<ASTNode>>& body, vector<shared_ptr<ASTNode>>& preheader, shared_ptr<ASTNode>& guard) {
+    loopEffects = SideEffects();
+    collectSideEffects(loop, loopEffects);
+
+    //jumps into the loop would skip the preheader
+    if (loopEffects.hasLabel) {
+        return;
+    }
+
+    hoisted.clear();
+
+    //the entry test keeps the original condition, the preheader runs after it
+    shared_ptr<ASTNode> originalCondition = cloneNode(condition);
+    condition = hoistExpression(condition, Type(TypeType::INT), true);
+    hoistStatements(body, true);
+    if (update != nullptr) {
+        hoistStatement(*update, false);
+    }
+
+    if (hoisted.empty()) {
+        return;
+    }
+
+    for (const HoistedExpression& x : hoisted) {
+        preheader.push_back(make_shared<AssignmentNode>(make_shared<IdentifierNode>(x.temporary), x.expression));
+    }
+    if (guard == nullptr && !equalExpressions(condition, originalCondition)) {
+        guard = originalCondition;
+    }
+}
+
+//guaranteed: statement runs in every iteration that reaches the end of the body, memory reads may be hoisted
+void LoopInvariantCodeMotion::hoistStatements(vector<shared_ptr<ASTNode>>& block, bool guaranteed) {
+    for (const shared_ptr<ASTNode>& node : block) {
+        hoistStatement(node, guaranteed);
+
+        if (!dynamic_pointer_cast<AssignmentNode>(node) && !dynamic_pointer_cast<VariableDeclarationNode>(node) && !dynamic_pointer_cast<FunctionCallNode>(node)) {
+            guaranteed = false;
+        }
+    }
+}
+
+//expected types are the ones the generator evaluates the expressions with
+void LoopInvariantCodeMotion::hoistStatement(const shared_ptr<ASTNode>& node, bool guaranteed) {
+    if (auto x = dynamic_pointer_cast<VariableDeclarationNode>(node)) {
+        x->value = hoistExpression(x->value, x->varType, guaranteed);
+    }
+    else if (auto x = dynamic_pointer_cast<AssignmentNode>(node)) {
+        Type type = SKIP_IDENT_NAMES.count(x->variable->name) ? Type(TypeType::INT) : variables().at(x->variable->name);
+        if (x->variable->index != nullptr) {
+            type = convertArrayToVarType(type);
+            x->variable->index = hoistExpression(x->variable->index, Type(TypeType::INT), guaranteed);
+        }
+        x->expression = hoistExpression(x->expression, type, guaranteed);
+    }
+    else if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        hoistArguments(x, guaranteed);
+    }
+    else if (auto x = dynamic_pointer_cast<ReturnValueNode>(node)) {
+        x->value = hoistExpression(x->value, returnType, guaranteed);
+    }
+    else if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+        x->condition = hoistExpression(x->condition, Type(TypeType::INT), guaranteed);
+        hoistStatements(x->thenBlock, false);
+        hoistStatements(x->elseBlock, false);
+    }
+    else if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+        x->condition = hoistExpression(x->condition, Type(TypeType::INT), false);
+        hoistStatements(x->body, false);
+    }
+    else if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+        hoistStatement(x->init, guaranteed);
+        x->condition = hoistExpression(x->condition, Type(TypeType::INT), false);
+        hoistStatement(x->update, false);
+        hoistStatements(x->body, false);
+    }
+    else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+        hoistStatements(x->body, false);
+    }
+    else if (auto x = dynamic_pointer_cast<ArrayDeclarationNode>(node)) {
+        Type elementType = convertArrayToVarType(x->type);
+        for (auto& value : x->arrayValues) {
+            value = hoistExpression(value, elementType, guaranteed);
+        }
+    }
+}
+
+void LoopInvariantCodeMotion::hoistArguments(const shared_ptr<FunctionCallNode>& call, bool guaranteed) {
+    const string& name = call->functionName;
+    if (name == LENGTH_FUNCTION) {
+        return;
+    }
+    if (name == OUTPUT_FUNCTION || name == DREF_FUNCTION || name == SREF_FUNCTION) {
+        //second @sref argument has to stay an identifier
+        call->arguments.at(0) = hoistExpression(call->arguments.at(0), Type(TypeType::INT), guaranteed);
+        return;
+    }
+
+    //resolve before arguments are replaced, temporaries change the argument types
+    FunctionDescr descr = findCallDescr(call, variables(), context.function_descrs);
+    for (int i = 0; i < call->arguments.size(); i++) {
+        call->arguments.at(i) = hoistExpression(call->arguments.at(i), descr.params.at(i).second, guaranteed);
+    }
+}
+
+shared_ptr<ASTNode> LoopInvariantCodeMotion::hoistExpression(const shared_ptr<ASTNode>& node, const Type& expected_type, bool guaranteed) {
+    if (node == nullptr) {
+        return node;
+    }
+
+    if (isCandidate(node) && isInvariant(node) && (guaranteed || !mayTrap(node))) {
+        for (const HoistedExpression& x : hoisted) {
+            if (x.type.getEnum() == expected_type.getEnum() && equalExpressions(x.expression, node)) {
+                return make_shared<IdentifierNode>(x.temporary);
+            }
+        }
+        string temporary = context.newTemporary(functionName, "licm", expected_type);
+        hoisted.push_back({node, expected_type, temporary});
+        return make_shared<IdentifierNode>(temporary);
+    }
+
+    if (auto x = dynamic_pointer_cast<ArithmeticNode>(node)) {
+        x->left = hoistExpression(x->left, expected_type, guaranteed);
+        x->right = hoistExpression(x->right, expected_type, guaranteed);
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNode>(node)) {
+        bool shortCircuit = x->logicalType == LogicalType::AND || x->logicalType == LogicalType::OR;
+        x->left = hoistExpression(x->left, Type(TypeType::INT), guaranteed);
+        x->right = hoistExpression(x->right, Type(TypeType::INT), guaranteed && !shortCircuit);
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNotNode>(node)) {
+        x->operand = hoistExpression(x->operand, Type(TypeType::INT), guaranteed);
+    }
+    else if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+        x->index = hoistExpression(x->index, Type(TypeType::INT), guaranteed);
+    }
+    else if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        hoistArguments(x, guaranteed);
+    }
+    return node;
+}
+
+//worth a temporary: arithmetic, array element reads and @dref
+bool LoopInvariantCodeMotion::isCandidate(const shared_ptr<ASTNode>& node) {
+    if (dynamic_pointer_cast<ArithmeticNode>(node)) {
+        return true;
+    }
+    if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+        return x->index != nullptr;
+    }
+    if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        return x->functionName == DREF_FUNCTION;
+    }
+    return false;
+}
+
+bool LoopInvariantCodeMotion::isInvariant(const shared_ptr<ASTNode>& node) {
+    if (node == nullptr || dynamic_pointer_cast<NumberNode>(node)) {
+        return true;
+    }
+    if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+        if (loopEffects.writtenVariables.count(x->name)) {
+            return false;
+        }
+        //@HP/@FREE are changed by calls, array elements by any store
+        if ((x->index != nullptr || SKIP_IDENT_NAMES.count(x->name) || isMemoryAlias(x->name)) && loopEffects.writesMemory) {
+            return false;
+        }
+        if (isMemoryAlias(x->name) && loopEffects.writtenVariables.count(x->name.substr(1))) {
+            return false;
+        }
+        return isInvariant(x->index);
+    }
+    if (auto x = dynamic_pointer_cast<ArithmeticNode>(node)) {
+        return isInvariant(x->left) && isInvariant(x->right);
+    }
+    if (auto x = dynamic_pointer_cast<LogicalNode>(node)) {
+        return isInvariant(x->left) && isInvariant(x->right);
+    }
+    if (auto x = dynamic_pointer_cast<LogicalNotNode>(node)) {
+        return isInvariant(x->operand);
+    }
+    if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        if (x->functionName == LENGTH_FUNCTION || x->functionName == DREF_FUNCTION) {
+            return !loopEffects.writesMemory && isInvariant(x->arguments.at(0));
+        }
+    }
+    return false;
+}
+
+//reads memory or divides by a non constant: only hoisted if executed in every iteration
+bool LoopInvariantCodeMotion::mayTrap(const shared_ptr<ASTNode>& node) {
+    if (node == nullptr) {
+        return false;
+    }
+    if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+        return x->index != nullptr || isMemoryAlias(x->name);
+    }
+    if (auto x = dynamic_pointer_cast<ArithmeticNode>(node)) {
+        if (x->arithmeticType == ArithmeticType::DIVIDE || x->arithmeticType == ArithmeticType::MODULO) {
+            auto divisor = dynamic_pointer_cast<NumberNode>(x->right);
+            if (divisor == nullptr || divisor->value == 0) {
+                return true;
+            }
+        }
+        return mayTrap(x->left) || mayTrap(x->right);
+    }
+    if (auto x = dynamic_pointer_cast<LogicalNode>(node)) {
+        return mayTrap(x->left) || mayTrap(x->right);
+    }
+    if (auto x = dynamic_pointer_cast<LogicalNotNode>(node)) {
+        return mayTrap(x->operand);
+    }
+    if (dynamic_pointer_cast<FunctionCallNode>(node)) {
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,37 @@
+#ifndef LICM_HPP
+#define LICM_HPP
+
+#include "optimizer.hpp"
+
+//hoists loop invariant expressions of while/for loops into the loop preheader
+class LoopInvariantCodeMotion {
+public:
+    explicit LoopInvariantCodeMotion(OptimizerContext&);
+    void run(const shared_ptr<FunctionDefinitionNode>&);
+
+private:
+    struct HoistedExpression {
+        shared_ptr<ASTNode> expression;
+        Type type;
+        string temporary;
+    };
+
+    OptimizerContext& context;
+    string functionName;
+    Type returnType;
+    SideEffects loopEffects;
+    vector<HoistedExpression> hoisted;
+
+    void processBlock(vector<shared_ptr<ASTNode>>&);
+    void processLoop(shared_ptr<ASTNode>& loop, shared_ptr<ASTNode>& condition, shared_ptr<ASTNode>* update, vector<shared_ptr<ASTNode>>& body, vector<shared_ptr<ASTNode>>& preheader, shared_ptr<ASTNode>& guard);
+    void hoistStatements(vector<shared_ptr<ASTNode>>&, bool guaranteed);
+    void hoistStatement(const shared_ptr<ASTNode>&, bool guaranteed);
+    shared_ptr<ASTNode> hoistExpression(const shared_ptr<ASTNode>&, const Type& expected_type, bool guaranteed);
+    void hoistArguments(const shared_ptr<FunctionCallNode>&, bool guaranteed);
+    bool isInvariant(const shared_ptr<ASTNode>&);
+    static bool isCandidate(const shared_ptr<ASTNode>&);
+    static bool mayTrap(const shared_ptr<ASTNode>&);
+    const unordered_map<string, Type>& variables();
+};
+
+#endif //LICM_HPP
@@ -8,18 +8,49 @@
 #include "parser.hpp"
 #include "analyzer.hpp"
 #include "rewriter.hpp"
+#include "optimizer.hpp"
+#include "dfe.hpp"
+#include "ir.hpp"
+#include "ssa.hpp"
 
 void writeFile(string output, string filename, bool log);
+bool parseOption(const string& argument, OptimizerOptions& options);
 
 int main(int argc, char* argv[]) {
     bool log = false;
+    bool emitIR = false;
+    bool destructSSA = false; //-emit-ir=destructed: phis replaced by copies
+
+    //options may appear anywhere, the remaining arguments are: input [output stdlib]
+    OptimizerOptions options;
+    vector<string> arguments;
+    for (int i = 1; i < argc; i++) {
+        string argument = argv[i];
+        if (argument == "-emit-ir" || argument == "-emit-ir=destructed") {
+            emitIR = true;
+            destructSSA = argument != "-emit-ir";
+            continue;
+        }
+        if (argument.size() > 1 && argument[0] == '-') {
+            if (!parseOption(argument, options)) {
+                cerr << "unknown option: " << argument << "\n";
+                return 1;
+            }
+            continue;
+        }
+        arguments.push_back(argument);
+    }
+    if (arguments.empty()) {
+        cerr << "usage: scmi_compiler input.sc [output.mi stdlib.sc] [-O0|-O1|-O2|-O3] [-funroll-factor=N] [-funroll-budget=N] [-fomit-frame-pointer] [-emit-ir[=destructed]]\n";
+        return 1;
+    }
 
-    string inputFile = argv[1];
+    string inputFile = arguments[0];
     string outputFile;
     string stdlib;
-    if (argc == 4) {
-        outputFile = argv[2];
-        stdlib = argv[3];
+    if (arguments.size() == 3) {
+        outputFile = arguments[1];
+        stdlib = arguments[2];
     }
     else {
         stdlib = "./stdlib.sc";
@@ -57,10 +88,12 @@ int main(int argc, char* argv[]) {
         auto std_ast = std_parser.parse();
 
         //if (log) std::cout << "\n=== DEBUG ===\n";
+        size_t firstStdlib = ast.size();
         for(auto node : std_ast) {
             ast.push_back(node);
             //if (log) node->print();
         }
+        removeUnusedStdlibFunctions(ast, firstStdlib);
 
         // Run semantic analysis
         if (log) std::cout << "\n=== Running Semantic Analysis ===\n";
@@ -71,6 +104,14 @@ int main(int argc, char* argv[]) {
         if (log) std::cout << "=================================\n";
 
 
+        if (log) std::cout << "\n=== Running Optimizer ===\n";
+
+        Optimizer optimizer(analysis.first, analysis.second, options);
+        optimizer.optimize(ast);
+
+        if (log) std::cout << "=========================\n";
+
+
         if (log) std::cout << "\n=== Running Rewriter ===\n";
 
         Rewriter rewriter;
@@ -89,8 +130,24 @@ int main(int argc, char* argv[]) {
         if (log) std::cout << "=========================\n";
 
 
+        //SSA form of every function on stdout, or the code after SSA destruction
+        if (emitIR) {
+            for (const auto& root : ast) {
+                auto function = dynamic_pointer_cast<FunctionDefinitionNode>(root);
+                IRBuilder builder(analysis.first, analysis.second.at(function->functionName));
+                IRFunction ir = builder.build(function);
+                SSABuilder ssa(ir);
+                ssa.construct();
+                if (destructSSA) {
+                    ssa.destruct();
+                }
+                cout << ir.toString() << "\n";
+            }
+        }
+
+
         if (log) cout << "\n=== COMPILE Output ===\n";
-        string output = compile(ast, analysis.first, analysis.second);
+        string output = compile(ast, analysis.first, analysis.second, options);
         if (log) cout << output << endl;
         writeFile(output, outputFile, log);
         if (log) cout << "======================\n";
@@ -102,6 +159,34 @@ int main(int argc, char* argv[]) {
     return 0;
 }
 
+//-O0: no AST passes, variables in the frame
+//-O1: pure function evaluation, specialization, inlining, LICM, strength reduction, CSE, DCE, tail calls,
+//     dead function removal (Optimizer::optimize), register allocation and static frames (compile)
+//-O2/-O3: also loop unrolling and a larger inlining limit
+bool parseOption(const string& argument, OptimizerOptions& options) {
+    if (argument.size() == 3 && argument.rfind("-O", 0) == 0 && argument[2] >= '0' && argument[2] <= '3') {
+        options.level = argument[2] - '0';
+        return true;
+    }
+    if (argument == "-fomit-frame-pointer") {
+        options.omitFramePointer = true;
+        return true;
+    }
+
+    auto parseValue = [&](const string& prefix, int& value) {
+        if (argument.rfind(prefix, 0) != 0) {
+            return false;
+        }
+        try {
+            value = stoi(argument.substr(prefix.size()));
+        } catch (const exception&) {
+            return false;
+        }
+        return value >= 0;
+    };
+    return parseValue("-funroll-factor=", options.unrollFactor) || parseValue("-funroll-budget=", options.unrollBudget);
+}
+
 void writeFile(string output, string filename, bool log) {
     std::ofstream file(filename);
 
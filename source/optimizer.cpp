@@ -0,0 +1,692 @@
+#include "optimizer.hpp"
+
+#include "cse.hpp"
+#include "dce.hpp"
+#include "dfe.hpp"
+#include "inliner.hpp"
+#include "ivsr.hpp"
+#include "licm.hpp"
+#include "pure.hpp"
+#include "specialize.hpp"
+#include "tailcall.hpp"
+#include "unroll.hpp"
+
+string OptimizerContext::newTemporary(const string& functionName, const string& base, const Type& type) {
+    string name = "%" + base + to_string(temporaryNum++);
+    variables.at(functionName)[name] = type;
+    return name;
+}
+
+string OptimizerContext::newMemoryAlias(const string& functionName, const string& pointer, const Type& type) {
+    string name = "*" + pointer;
+    variables.at(functionName)[name] = type;
+    return name;
+}
+
+Optimizer::Optimizer(vector<FunctionDescr>& function_descrs, unordered_map<string, unordered_map<string, Type>>& variables, const OptimizerOptions& options)
+    : context{function_descrs, variables, options} {}
+
+//runs all AST passes on every function, before loops are lowered by the Rewriter
+void Optimizer::optimize(vector<shared_ptr<ASTNode>>& ast) {
+    if (context.options.level == 0) {
+        return;
+    }
+
+    PureFunctionEvaluation pureFunctions(context);
+    pureFunctions.run(ast);
+
+    FunctionSpecialization specialization(context);
+    specialization.run(ast);
+
+    FunctionInliner inliner(context, ast);
+    for (const shared_ptr<ASTNode>& node : ast) {
+        shared_ptr<FunctionDefinitionNode> function = dynamic_pointer_cast<FunctionDefinitionNode>(node);
+        if (function == nullptr) {
+            continue;
+        }
+
+        inliner.run(function);
+
+        if (context.options.level >= 2) {
+            LoopUnroller unroller(context);
+            unroller.run(function);
+        }
+
+        LoopInvariantCodeMotion licm(context);
+        licm.run(function);
+
+        InductionVariableStrengthReduction ivsr(context);
+        ivsr.run(function);
+
+        CommonSubexpressionElimination cse(context);
+        cse.run(function);
+
+        DeadCodeElimination dce(context);
+        dce.run(function);
+    }
+
+    //after inlining, marked tail calls must stay in their function
+    for (const shared_ptr<ASTNode>& node : ast) {
+        if (shared_ptr<FunctionDefinitionNode> function = dynamic_pointer_cast<FunctionDefinitionNode>(node)) {
+            TailCallElimination tailCalls(context);
+            tailCalls.run(function);
+        }
+    }
+
+    DeadFunctionElimination dfe(context);
+    dfe.run(ast);
+}
+
+bool isBuiltinFunction(const string& name) {
+    return name == OUTPUT_FUNCTION || name == LENGTH_FUNCTION || name == DREF_FUNCTION || name == SREF_FUNCTION;
+}
+
+//{1, 2, 3} or a string literal, the generator emits it as DD data
+bool hasConstantInitializer(const shared_ptr<ArrayDeclarationNode>& arr) {
+    if (arr->size != -1 || arr->arrayValues.empty()) {
+        return false;
+    }
+    for (const auto& value : arr->arrayValues) {
+        if (dynamic_pointer_cast<NumberNode>(value) == nullptr) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//structural equality of expressions
+bool equalExpressions(const shared_ptr<ASTNode>& a, const shared_ptr<ASTNode>& b) {
+    if (a == nullptr || b == nullptr) {
+        return a == b;
+    }
+    if (auto x = dynamic_pointer_cast<NumberNode>(a)) {
+        auto y = dynamic_pointer_cast<NumberNode>(b);
+        return y && x->value == y->value;
+    }
+    if (auto x = dynamic_pointer_cast<IdentifierNode>(a)) {
+        auto y = dynamic_pointer_cast<IdentifierNode>(b);
+        return y && x->name == y->name && equalExpressions(x->index, y->index);
+    }
+    if (auto x = dynamic_pointer_cast<ArithmeticNode>(a)) {
+        auto y = dynamic_pointer_cast<ArithmeticNode>(b);
+        return y && x->arithmeticType == y->arithmeticType && equalExpressions(x->left, y->left) && equalExpressions(x->right, y->right);
+    }
+    if (auto x = dynamic_pointer_cast<LogicalNode>(a)) {
+        auto y = dynamic_pointer_cast<LogicalNode>(b);
+        return y && x->logicalType == y->logicalType && equalExpressions(x->left, y->left) && equalExpressions(x->right, y->right);
+    }
+    if (auto x = dynamic_pointer_cast<LogicalNotNode>(a)) {
+        auto y = dynamic_pointer_cast<LogicalNotNode>(b);
+        return y && equalExpressions(x->operand, y->operand);
+    }
+    if (auto x = dynamic_pointer_cast<FunctionCallNode>(a)) {
+        auto y = dynamic_pointer_cast<FunctionCallNode>(b);
+        if (!y || x->functionName != y->functionName || x->arguments.size() != y->arguments.size()) {
+            return false;
+        }
+        for (int i = 0; i < x->arguments.size(); i++) {
+            if (!equalExpressions(x->arguments[i], y->arguments[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+void collectSideEffects(const vector<shared_ptr<ASTNode>>& nodes, SideEffects& effects) {
+    for (const auto& node : nodes) {
+        collectSideEffects(node, effects);
+    }
+}
+
+void collectSideEffects(const shared_ptr<ASTNode>& node, SideEffects& effects) {
+    if (node == nullptr) {
+        return;
+    }
+    if (auto x = dynamic_pointer_cast<VariableDeclarationNode>(node)) {
+        effects.writtenVariables.insert(x->varName);
+        collectSideEffects(x->value, effects);
+    }
+    else if (auto x = dynamic_pointer_cast<AssignmentNode>(node)) {
+        if (x->variable->index != nullptr || SKIP_IDENT_NAMES.count(x->variable->name) || isMemoryAlias(x->variable->name)) {
+            effects.writesMemory = true;
+        }
+        if (x->variable->index == nullptr) {
+            effects.writtenVariables.insert(x->variable->name);
+        }
+        collectSideEffects(x->variable->index, effects);
+        collectSideEffects(x->expression, effects);
+    }
+    else if (auto x = dynamic_pointer_cast<ArrayDeclarationNode>(node)) {
+        //malloc call
+        effects.writtenVariables.insert(x->name);
+        effects.writesMemory = true;
+        effects.hasCall = true;
+        collectSideEffects(x->arrayValues, effects);
+    }
+    else if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        if (x->functionName == SREF_FUNCTION) {
+            effects.writesMemory = true;
+        }
+        else if (!isBuiltinFunction(x->functionName)) {
+            effects.writesMemory = true;
+            effects.hasCall = true;
+        }
+        collectSideEffects(x->arguments, effects);
+    }
+    else if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+        collectSideEffects(x->condition, effects);
+        collectSideEffects(x->thenBlock, effects);
+        collectSideEffects(x->elseBlock, effects);
+    }
+    else if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+        collectSideEffects(x->condition, effects);
+        collectSideEffects(x->guard, effects);
+        collectSideEffects(x->preheader, effects);
+        collectSideEffects(x->body, effects);
+    }
+    else if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+        collectSideEffects(x->init, effects);
+        collectSideEffects(x->condition, effects);
+        collectSideEffects(x->guard, effects);
+        collectSideEffects(x->update, effects);
+        collectSideEffects(x->preheader, effects);
+        collectSideEffects(x->body, effects);
+    }
+    else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+        collectSideEffects(x->body, effects);
+    }
+    else if (dynamic_pointer_cast<LabelNode>(node)) {
+        effects.hasLabel = true;
+    }
+    else if (auto x = dynamic_pointer_cast<ReturnValueNode>(node)) {
+        collectSideEffects(x->value, effects);
+    }
+    else if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+        collectSideEffects(x->index, effects);
+    }
+    else if (auto x = dynamic_pointer_cast<ArithmeticNode>(node)) {
+        collectSideEffects(x->left, effects);
+        collectSideEffects(x->right, effects);
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNode>(node)) {
+        collectSideEffects(x->left, effects);
+        collectSideEffects(x->right, effects);
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNotNode>(node)) {
+        collectSideEffects(x->operand, effects);
+    }
+}
+
+//all variable names read by an expression (array names included)
+void collectReadVariables(const shared_ptr<ASTNode>& node, unordered_set<string>& variables) {
+    if (node == nullptr) {
+        return;
+    }
+    if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+        variables.insert(x->name);
+        if (isMemoryAlias(x->name)) {
+            variables.insert(x->name.substr(1));
+        }
+        collectReadVariables(x->index, variables);
+    }
+    else if (auto x = dynamic_pointer_cast<ArithmeticNode>(node)) {
+        collectReadVariables(x->left, variables);
+        collectReadVariables(x->right, variables);
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNode>(node)) {
+        collectReadVariables(x->left, variables);
+        collectReadVariables(x->right, variables);
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNotNode>(node)) {
+        collectReadVariables(x->operand, variables);
+    }
+    else if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        for (const auto& argument : x->arguments) {
+            collectReadVariables(argument, variables);
+        }
+    }
+}
+
+//all variables read anywhere in a statement tree, except inside exclude
+void collectStatementReads(const shared_ptr<ASTNode>& node, unordered_set<string>& variables, const ASTNode* exclude) {
+    if (node == nullptr || node.get() == exclude) {
+        return;
+    }
+    if (auto x = dynamic_pointer_cast<VariableDeclarationNode>(node)) {
+        collectReadVariables(x->value, variables);
+    }
+    else if (auto x = dynamic_pointer_cast<AssignmentNode>(node)) {
+        //element store reads the array pointer
+        if (x->variable->index != nullptr) {
+            variables.insert(x->variable->name);
+            collectReadVariables(x->variable->index, variables);
+        }
+        if (isMemoryAlias(x->variable->name)) {
+            variables.insert(x->variable->name.substr(1));
+        }
+        collectReadVariables(x->expression, variables);
+    }
+    else if (auto x = dynamic_pointer_cast<ArrayDeclarationNode>(node)) {
+        for (const auto& value : x->arrayValues) {
+            collectReadVariables(value, variables);
+        }
+    }
+    else if (auto x = dynamic_pointer_cast<ReturnValueNode>(node)) {
+        collectReadVariables(x->value, variables);
+    }
+    else if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+        collectReadVariables(x->condition, variables);
+        for (const auto& stmt : x->thenBlock) collectStatementReads(stmt, variables, exclude);
+        for (const auto& stmt : x->elseBlock) collectStatementReads(stmt, variables, exclude);
+    }
+    else if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+        collectReadVariables(x->condition, variables);
+        collectReadVariables(x->guard, variables);
+        for (const auto& stmt : x->preheader) collectStatementReads(stmt, variables, exclude);
+        for (const auto& stmt : x->body) collectStatementReads(stmt, variables, exclude);
+    }
+    else if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+        collectStatementReads(x->init, variables, exclude);
+        collectReadVariables(x->condition, variables);
+        collectReadVariables(x->guard, variables);
+        collectStatementReads(x->update, variables, exclude);
+        for (const auto& stmt : x->preheader) collectStatementReads(stmt, variables, exclude);
+        for (const auto& stmt : x->body) collectStatementReads(stmt, variables, exclude);
+    }
+    else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+        for (const auto& stmt : x->body) collectStatementReads(stmt, variables, exclude);
+    }
+    else {
+        collectReadVariables(node, variables);
+    }
+}
+
+//calls visit for node and every statement and expression below it, parents first
+void visitNodes(const shared_ptr<ASTNode>& node, const function<void(const shared_ptr<ASTNode>&)>& visit) {
+    if (node == nullptr) {
+        return;
+    }
+    visit(node);
+    auto visitBlock = [&](const vector<shared_ptr<ASTNode>>& block) {
+        for (const auto& stmt : block) visitNodes(stmt, visit);
+    };
+
+    if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+        visitNodes(x->index, visit);
+    }
+    else if (auto x = dynamic_pointer_cast<VariableDeclarationNode>(node)) {
+        visitNodes(x->value, visit);
+    }
+    else if (auto x = dynamic_pointer_cast<AssignmentNode>(node)) {
+        visitNodes(x->variable, visit);
+        visitNodes(x->expression, visit);
+    }
+    else if (auto x = dynamic_pointer_cast<ArrayDeclarationNode>(node)) {
+        visitBlock(x->arrayValues);
+    }
+    else if (auto x = dynamic_pointer_cast<ReturnValueNode>(node)) {
+        visitNodes(x->value, visit);
+    }
+    else if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+        visitNodes(x->condition, visit);
+        visitBlock(x->thenBlock);
+        visitBlock(x->elseBlock);
+    }
+    else if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+        visitNodes(x->condition, visit);
+        visitNodes(x->guard, visit);
+        visitBlock(x->preheader);
+        visitBlock(x->body);
+    }
+    else if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+        visitNodes(x->init, visit);
+        visitNodes(x->condition, visit);
+        visitNodes(x->guard, visit);
+        visitNodes(x->update, visit);
+        visitBlock(x->preheader);
+        visitBlock(x->body);
+    }
+    else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+        visitBlock(x->body);
+    }
+    else if (auto x = dynamic_pointer_cast<ArithmeticNode>(node)) {
+        visitNodes(x->left, visit);
+        visitNodes(x->right, visit);
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNode>(node)) {
+        visitNodes(x->left, visit);
+        visitNodes(x->right, visit);
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNotNode>(node)) {
+        visitNodes(x->operand, visit);
+    }
+    else if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        visitBlock(x->arguments);
+    }
+}
+
+//replaces reads of the (scalar) variable name by copies of replacement, works in place on statements
+shared_ptr<ASTNode> substituteVariable(const shared_ptr<ASTNode>& node, const string& name, const shared_ptr<ASTNode>& replacement) {
+    if (node == nullptr) {
+        return node;
+    }
+    auto substituteBlock = [&](vector<shared_ptr<ASTNode>>& block) {
+        for (auto& stmt : block) stmt = substituteVariable(stmt, name, replacement);
+    };
+
+    if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+        if (x->name == name && x->index == nullptr) {
+            return cloneNode(replacement);
+        }
+        x->index = substituteVariable(x->index, name, replacement);
+    }
+    else if (auto x = dynamic_pointer_cast<VariableDeclarationNode>(node)) {
+        x->value = substituteVariable(x->value, name, replacement);
+    }
+    else if (auto x = dynamic_pointer_cast<AssignmentNode>(node)) {
+        //target stays, only its index is read
+        x->variable->index = substituteVariable(x->variable->index, name, replacement);
+        x->expression = substituteVariable(x->expression, name, replacement);
+    }
+    else if (auto x = dynamic_pointer_cast<ArrayDeclarationNode>(node)) {
+        substituteBlock(x->arrayValues);
+    }
+    else if (auto x = dynamic_pointer_cast<ReturnValueNode>(node)) {
+        x->value = substituteVariable(x->value, name, replacement);
+    }
+    else if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+        x->condition = substituteVariable(x->condition, name, replacement);
+        substituteBlock(x->thenBlock);
+        substituteBlock(x->elseBlock);
+    }
+    else if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+        x->condition = substituteVariable(x->condition, name, replacement);
+        x->guard = substituteVariable(x->guard, name, replacement);
+        substituteBlock(x->preheader);
+        substituteBlock(x->body);
+    }
+    else if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+        x->init = substituteVariable(x->init, name, replacement);
+        x->condition = substituteVariable(x->condition, name, replacement);
+        x->guard = substituteVariable(x->guard, name, replacement);
+        x->update = substituteVariable(x->update, name, replacement);
+        substituteBlock(x->preheader);
+        substituteBlock(x->body);
+    }
+    else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+        substituteBlock(x->body);
+    }
+    else if (auto x = dynamic_pointer_cast<ArithmeticNode>(node)) {
+        x->left = substituteVariable(x->left, name, replacement);
+        x->right = substituteVariable(x->right, name, replacement);
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNode>(node)) {
+        x->left = substituteVariable(x->left, name, replacement);
+        x->right = substituteVariable(x->right, name, replacement);
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNotNode>(node)) {
+        x->operand = substituteVariable(x->operand, name, replacement);
+    }
+    else if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        //second @sref argument has to stay an identifier
+        for (int i = 0; i < x->arguments.size(); i++) {
+            if (x->functionName != SREF_FUNCTION || i == 0) {
+                x->arguments[i] = substituteVariable(x->arguments[i], name, replacement);
+            }
+        }
+    }
+    return node;
+}
+
+//arithmetic on two numbers, only results 0..255 that are the same in a char or int context; works in place on statements
+shared_ptr<ASTNode> foldConstants(const shared_ptr<ASTNode>& node) {
+    if (node == nullptr) {
+        return node;
+    }
+    auto foldBlock = [](vector<shared_ptr<ASTNode>>& block) {
+        for (auto& stmt : block) stmt = foldConstants(stmt);
+    };
+
+    if (auto x = dynamic_pointer_cast<ArithmeticNode>(node)) {
+        x->left = foldConstants(x->left);
+        x->right = foldConstants(x->right);
+        auto left = dynamic_pointer_cast<NumberNode>(x->left);
+        auto right = dynamic_pointer_cast<NumberNode>(x->right);
+        if (left == nullptr || right == nullptr) {
+            return node;
+        }
+
+        long long a = left->value;
+        long long b = right->value;
+        long long result;
+        switch (x->arithmeticType) {
+            case ArithmeticType::ADD: result = a + b; break;
+            case ArithmeticType::SUBTRACT: result = a - b; break;
+            case ArithmeticType::MULTIPLY: result = a * b; break;
+            case ArithmeticType::DIVIDE:
+            case ArithmeticType::MODULO:
+                if (a < 0 || b <= 0) {
+                    return node;
+                }
+                result = x->arithmeticType == ArithmeticType::DIVIDE ? a / b : a % b;
+                break;
+            default: return node;
+        }
+        if (result < 0 || result > 255) {
+            return node;
+        }
+        return make_shared<NumberNode>(result);
+    }
+    if (auto x = dynamic_pointer_cast<LogicalNode>(node)) {
+        x->left = foldConstants(x->left);
+        x->right = foldConstants(x->right);
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNotNode>(node)) {
+        x->operand = foldConstants(x->operand);
+    }
+    else if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+        x->index = foldConstants(x->index);
+    }
+    else if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        foldBlock(x->arguments);
+    }
+    else if (auto x = dynamic_pointer_cast<VariableDeclarationNode>(node)) {
+        x->value = foldConstants(x->value);
+    }
+    else if (auto x = dynamic_pointer_cast<AssignmentNode>(node)) {
+        x->variable->index = foldConstants(x->variable->index);
+        x->expression = foldConstants(x->expression);
+    }
+    else if (auto x = dynamic_pointer_cast<ArrayDeclarationNode>(node)) {
+        foldBlock(x->arrayValues);
+    }
+    else if (auto x = dynamic_pointer_cast<ReturnValueNode>(node)) {
+        x->value = foldConstants(x->value);
+    }
+    else if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+        x->condition = foldConstants(x->condition);
+        foldBlock(x->thenBlock);
+        foldBlock(x->elseBlock);
+    }
+    else if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+        x->condition = foldConstants(x->condition);
+        x->guard = foldConstants(x->guard);
+        foldBlock(x->preheader);
+        foldBlock(x->body);
+    }
+    else if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+        x->init = foldConstants(x->init);
+        x->condition = foldConstants(x->condition);
+        x->guard = foldConstants(x->guard);
+        x->update = foldConstants(x->update);
+        foldBlock(x->preheader);
+        foldBlock(x->body);
+    }
+    else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+        foldBlock(x->body);
+    }
+    return node;
+}
+
+//comparison of two numbers
+bool isConstantCondition(const shared_ptr<ASTNode>& condition, bool& value) {
+    auto x = dynamic_pointer_cast<LogicalNode>(condition);
+    if (x == nullptr) {
+        return false;
+    }
+    auto left = dynamic_pointer_cast<NumberNode>(x->left);
+    auto right = dynamic_pointer_cast<NumberNode>(x->right);
+    if (left == nullptr || right == nullptr) {
+        return false;
+    }
+
+    switch (x->logicalType) {
+        case LogicalType::EQUAL: value = left->value == right->value; return true;
+        case LogicalType::NOT_EQUAL: value = left->value != right->value; return true;
+        case LogicalType::LESS_THAN: value = left->value < right->value; return true;
+        case LogicalType::GREATER_THAN: value = left->value > right->value; return true;
+        case LogicalType::LESS_EQUAL: value = left->value <= right->value; return true;
+        case LogicalType::GREATER_EQUAL: value = left->value >= right->value; return true;
+        default: return false;
+    }
+}
+
+//size estimate of a statement or expression
+int countNodes(const shared_ptr<ASTNode>& node) {
+    if (node == nullptr) {
+        return 0;
+    }
+    auto countBlock = [](const vector<shared_ptr<ASTNode>>& block) {
+        int count = 0;
+        for (const auto& stmt : block) count += countNodes(stmt);
+        return count;
+    };
+
+    if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+        return 1 + countNodes(x->index);
+    }
+    if (auto x = dynamic_pointer_cast<VariableDeclarationNode>(node)) {
+        return 1 + countNodes(x->value);
+    }
+    if (auto x = dynamic_pointer_cast<AssignmentNode>(node)) {
+        return 1 + countNodes(x->variable) + countNodes(x->expression);
+    }
+    if (auto x = dynamic_pointer_cast<ArrayDeclarationNode>(node)) {
+        return 1 + countBlock(x->arrayValues);
+    }
+    if (auto x = dynamic_pointer_cast<ReturnValueNode>(node)) {
+        return 1 + countNodes(x->value);
+    }
+    if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+        return 1 + countNodes(x->condition) + countBlock(x->thenBlock) + countBlock(x->elseBlock);
+    }
+    if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+        return 1 + countNodes(x->condition) + countNodes(x->guard) + countBlock(x->preheader) + countBlock(x->body);
+    }
+    if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+        return 1 + countNodes(x->init) + countNodes(x->condition) + countNodes(x->guard) + countNodes(x->update) + countBlock(x->preheader) + countBlock(x->body);
+    }
+    if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+        return countBlock(x->body);
+    }
+    if (auto x = dynamic_pointer_cast<ArithmeticNode>(node)) {
+        return 1 + countNodes(x->left) + countNodes(x->right);
+    }
+    if (auto x = dynamic_pointer_cast<LogicalNode>(node)) {
+        return 1 + countNodes(x->left) + countNodes(x->right);
+    }
+    if (auto x = dynamic_pointer_cast<LogicalNotNode>(node)) {
+        return 1 + countNodes(x->operand);
+    }
+    if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        return 1 + countBlock(x->arguments);
+    }
+    return 1;
+}
+
+//c for 'i = i + c', 'i = c + i' and -c for 'i = i - c', 0 for anything else
+int getCounterStep(const shared_ptr<ASTNode>& update, const string& counter) {
+    auto assignment = dynamic_pointer_cast<AssignmentNode>(update);
+    if (assignment == nullptr || assignment->variable->name != counter || assignment->variable->index != nullptr) {
+        return 0;
+    }
+    auto increment = dynamic_pointer_cast<ArithmeticNode>(assignment->expression);
+    if (increment == nullptr) {
+        return 0;
+    }
+
+    auto isCounter = [&](const shared_ptr<ASTNode>& node) {
+        auto identifier = dynamic_pointer_cast<IdentifierNode>(node);
+        return identifier && identifier->name == counter && identifier->index == nullptr;
+    };
+    auto left = dynamic_pointer_cast<NumberNode>(increment->left);
+    auto right = dynamic_pointer_cast<NumberNode>(increment->right);
+    if (isCounter(increment->left) && right) {
+        if (increment->arithmeticType == ArithmeticType::ADD) return right->value;
+        if (increment->arithmeticType == ArithmeticType::SUBTRACT) return -right->value;
+    }
+    if (left && isCounter(increment->right) && increment->arithmeticType == ArithmeticType::ADD) {
+        return left->value;
+    }
+    return 0;
+}
+
+//a < b <=> b > a
+LogicalType mirrorCompare(LogicalType logical) {
+    switch (logical) {
+        case LogicalType::LESS_THAN: return LogicalType::GREATER_THAN;
+        case LogicalType::GREATER_THAN: return LogicalType::LESS_THAN;
+        case LogicalType::LESS_EQUAL: return LogicalType::GREATER_EQUAL;
+        case LogicalType::GREATER_EQUAL: return LogicalType::LESS_EQUAL;
+        default: return logical;
+    }
+}
+
+//same type rules as Function::getType in the generator
+Type getExpressionType(const shared_ptr<ASTNode>& node, const unordered_map<string, Type>& variables, const vector<FunctionDescr>& function_descrs) {
+    if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+        if (SKIP_IDENT_NAMES.count(x->name)) {
+            return Type(TypeType::INT);
+        }
+        if (x->index == nullptr) {
+            return variables.at(x->name);
+        }
+        return convertArrayToVarType(variables.at(x->name));
+    }
+    if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        if (x->functionName == LENGTH_FUNCTION || x->functionName == DREF_FUNCTION) {
+            return Type(TypeType::INT);
+        }
+        if (isBuiltinFunction(x->functionName)) {
+            return Type(TypeType::VOID);
+        }
+        return findCallDescr(x, variables, function_descrs).type;
+    }
+    return Type(TypeType::INT);
+}
+
+//overload resolution like Function::findFunctionDescr in the generator
+FunctionDescr findCallDescr(const shared_ptr<FunctionCallNode>& node, const unordered_map<string, Type>& variables, const vector<FunctionDescr>& function_descrs) {
+    for (const FunctionDescr& x : function_descrs) {
+        if (x.name != node->functionName || x.params.size() != node->arguments.size()) {
+            continue;
+        }
+        bool same = true;
+        for (int i = 0; i < x.params.size(); i++) {
+            Type type1 = x.params.at(i).second;
+            Type type2 = getExpressionType(node->arguments.at(i), variables, function_descrs);
+            if (type1.getEnum() != type2.getEnum()) {
+                same = false;
+            }
+            if (type1.getEnum() == TypeType::INT && type2.isArray()) {
+                same = true;
+            }
+        }
+        if (same) {
+            return x;
+        }
+    }
+    throw runtime_error("cannot find function: " + node->functionName);
+}
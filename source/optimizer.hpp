@@ -0,0 +1,71 @@
+#ifndef OPTIMIZER_HPP
+#define OPTIMIZER_HPP
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ast.h"
+#include "analyzer.hpp"
+
+using namespace std;
+
+//command line: -O0 .. -O3, -funroll-factor=N, -funroll-budget=N, -fomit-frame-pointer
+struct OptimizerOptions {
+    int level = 1;
+    int unrollFactor = 4;
+    int unrollBudget = 64; //AST nodes of an unrolled loop body
+    bool omitFramePointer = false;
+};
+
+//shared state of all AST passes, variables is the analyzer output (function -> variable -> type)
+struct OptimizerContext {
+    vector<FunctionDescr>& function_descrs;
+    unordered_map<string, unordered_map<string, Type>>& variables;
+    OptimizerOptions options;
+    int temporaryNum = 0;
+
+    //new compiler variable, '%' cannot appear in identifiers of the source language
+    string newTemporary(const string& functionName, const string& base, const Type& type);
+    //'*pointer' of the given type, the generator addresses it as !(pointer)
+    string newMemoryAlias(const string& functionName, const string& pointer, const Type& type);
+};
+
+//everything a statement (list) may change
+struct SideEffects {
+    unordered_set<string> writtenVariables;
+    bool writesMemory = false; //array element, @sref, @HP/@FREE or a call
+    bool hasLabel = false;
+    bool hasCall = false;
+};
+
+class Optimizer {
+public:
+    Optimizer(vector<FunctionDescr>&, unordered_map<string, unordered_map<string, Type>>&, const OptimizerOptions&);
+    void optimize(vector<shared_ptr<ASTNode>>& ast);
+
+private:
+    OptimizerContext context;
+};
+
+bool isBuiltinFunction(const string& name);
+bool hasConstantInitializer(const shared_ptr<ArrayDeclarationNode>&);
+bool equalExpressions(const shared_ptr<ASTNode>&, const shared_ptr<ASTNode>&);
+void collectSideEffects(const shared_ptr<ASTNode>&, SideEffects&);
+void collectSideEffects(const vector<shared_ptr<ASTNode>>&, SideEffects&);
+void collectReadVariables(const shared_ptr<ASTNode>&, unordered_set<string>&);
+void collectStatementReads(const shared_ptr<ASTNode>&, unordered_set<string>&, const ASTNode* exclude = nullptr);
+void visitNodes(const shared_ptr<ASTNode>&, const function<void(const shared_ptr<ASTNode>&)>& visit);
+shared_ptr<ASTNode> substituteVariable(const shared_ptr<ASTNode>&, const string& name, const shared_ptr<ASTNode>& replacement);
+shared_ptr<ASTNode> foldConstants(const shared_ptr<ASTNode>&);
+bool isConstantCondition(const shared_ptr<ASTNode>&, bool& value);
+int countNodes(const shared_ptr<ASTNode>&);
+int getCounterStep(const shared_ptr<ASTNode>& update, const string& counter);
+LogicalType mirrorCompare(LogicalType);
+Type getExpressionType(const shared_ptr<ASTNode>&, const unordered_map<string, Type>&, const vector<FunctionDescr>&);
+FunctionDescr findCallDescr(const shared_ptr<FunctionCallNode>&, const unordered_map<string, Type>&, const vector<FunctionDescr>&);
+
+#endif //OPTIMIZER_HPP
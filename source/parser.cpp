@@ -334,6 +334,17 @@ shared_ptr<ASTNode> Parser::parseStatement(bool semicolon) {
     }
 
 
+    //inline keyword identifier ( ... ) { ... }
+    if (peek().type == TokenType::KEYWORD && peek().keyword == KeywordType::INLINE) {
+        advance();
+        auto function = dynamic_pointer_cast<FunctionDefinitionNode>(parseStatement(semicolon));
+        if (function == nullptr) {
+            throw runtime_error("Parse Error: Expected function definition after 'inline' " + tokens[current - 1].where());
+        }
+        function->isInline = true;
+        return function;
+    }
+
     //Handle function definition
     //keyword identifier ( keyword identifier , keyword identifier ) { ... }
     if (peek().type == TokenType::KEYWORD && peek().keyword == KeywordType::TYPE && peek2().type == TokenType::IDENTIFIER && peek3().type == TokenType::L_PAREN) {
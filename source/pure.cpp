@@ -0,0 +1,218 @@
+#include "pure.hpp"
+
+#include <climits>
+
+PureFunctionEvaluation::PureFunctionEvaluation(OptimizerContext& context) : context(context) {}
+
+void PureFunctionEvaluation::run(vector<shared_ptr<ASTNode>>& ast) {
+    for (const shared_ptr<ASTNode>& node : ast) {
+        if (auto function = dynamic_pointer_cast<FunctionDefinitionNode>(node)) {
+            definitions[findFunctionDescr(function, context.function_descrs).address] = function;
+        }
+    }
+    findPureFunctions();
+
+    for (const shared_ptr<ASTNode>& node : ast) {
+        auto function = dynamic_pointer_cast<FunctionDefinitionNode>(node);
+        if (function == nullptr) {
+            continue;
+        }
+        functionName = function->functionName;
+        returnType = function->returnType;
+        for (const auto& stmt : function->body) {
+            replaceStatement(stmt);
+        }
+    }
+}
+
+//pure until a callee turns out to be impure
+void PureFunctionEvaluation::findPureFunctions() {
+    unordered_map<string, unordered_set<string>> callees;
+    for (const auto& [address, function] : definitions) {
+        if (isPureBody(function, callees[address])) {
+            pure.insert(address);
+        }
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto it = pure.begin(); it != pure.end();) {
+            bool callsImpure = false;
+            for (const string& callee : callees.at(*it)) {
+                callsImpure = callsImpure || !pure.count(callee);
+            }
+            if (callsImpure) {
+                it = pure.erase(it);
+                changed = true;
+            }
+            else {
+                it++;
+            }
+        }
+    }
+}
+
+//only int values, the interpreter has no char conversions
+bool PureFunctionEvaluation::isPureBody(const shared_ptr<FunctionDefinitionNode>& function, unordered_set<string>& callees) {
+    if (function->functionName == "main" || function->returnType.getEnum() != TypeType::INT) {
+        return false;
+    }
+    const unordered_map<string, Type>& variables = context.variables.at(function->functionName);
+    for (const auto& [name, type] : variables) {
+        if (type.getEnum() != TypeType::INT) {
+            return false;
+        }
+    }
+
+    bool isPure = true;
+    for (const auto& stmt : function->body) {
+        visitNodes(stmt, [&](const shared_ptr<ASTNode>& node) {
+            if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+                isPure = isPure && x->index == nullptr && !isMemoryAlias(x->name) && !SKIP_IDENT_NAMES.count(x->name);
+            }
+            else if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+                if (isBuiltinFunction(x->functionName)) {
+                    isPure = false;
+                    return;
+                }
+                callees.insert(findCallDescr(x, variables, context.function_descrs).address);
+            }
+            else if (dynamic_pointer_cast<ArrayDeclarationNode>(node) || dynamic_pointer_cast<LabelNode>(node) || dynamic_pointer_cast<GotoNode>(node)) {
+                isPure = false;
+            }
+        });
+    }
+    return isPure;
+}
+
+void PureFunctionEvaluation::replaceStatement(const shared_ptr<ASTNode>& node) {
+    if (node == nullptr) {
+        return;
+    }
+    const unordered_map<string, Type>& variables = context.variables.at(functionName);
+    if (auto x = dynamic_pointer_cast<VariableDeclarationNode>(node)) {
+        x->value = replaceExpression(x->value, x->varType.getEnum() == TypeType::CHAR);
+    }
+    else if (auto x = dynamic_pointer_cast<AssignmentNode>(node)) {
+        bool charContext = false;
+        if (!SKIP_IDENT_NAMES.count(x->variable->name)) {
+            Type type = variables.at(x->variable->name);
+            if (x->variable->index != nullptr) {
+                type = convertArrayToVarType(type);
+            }
+            charContext = type.getEnum() == TypeType::CHAR;
+        }
+        x->variable->index = replaceExpression(x->variable->index, false);
+        x->expression = replaceExpression(x->expression, charContext);
+    }
+    else if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        replaceExpression(x, false);
+    }
+    else if (auto x = dynamic_pointer_cast<ReturnValueNode>(node)) {
+        x->value = replaceExpression(x->value, returnType.getEnum() == TypeType::CHAR);
+    }
+    else if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+        x->condition = replaceExpression(x->condition, false);
+        for (const auto& stmt : x->thenBlock) replaceStatement(stmt);
+        for (const auto& stmt : x->elseBlock) replaceStatement(stmt);
+    }
+    else if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+        x->condition = replaceExpression(x->condition, false);
+        x->guard = replaceExpression(x->guard, false);
+        for (const auto& stmt : x->preheader) replaceStatement(stmt);
+        for (const auto& stmt : x->body) replaceStatement(stmt);
+    }
+    else if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+        replaceStatement(x->init);
+        x->condition = replaceExpression(x->condition, false);
+        x->guard = replaceExpression(x->guard, false);
+        replaceStatement(x->update);
+        for (const auto& stmt : x->preheader) replaceStatement(stmt);
+        for (const auto& stmt : x->body) replaceStatement(stmt);
+    }
+    else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+        for (const auto& stmt : x->body) replaceStatement(stmt);
+    }
+    else if (auto x = dynamic_pointer_cast<ArrayDeclarationNode>(node)) {
+        bool charContext = convertArrayToVarType(x->type).getEnum() == TypeType::CHAR;
+        for (auto& value : x->arrayValues) value = replaceExpression(value, charContext);
+    }
+}
+
+//charContext: the value is stored as byte, comparisons are word operations
+shared_ptr<ASTNode> PureFunctionEvaluation::replaceExpression(const shared_ptr<ASTNode>& node, bool charContext) {
+    if (node == nullptr) {
+        return node;
+    }
+    if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+        x->index = replaceExpression(x->index, false);
+    }
+    else if (auto x = dynamic_pointer_cast<ArithmeticNode>(node)) {
+        x->left = replaceExpression(x->left, charContext);
+        x->right = replaceExpression(x->right, charContext);
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNode>(node)) {
+        x->left = replaceExpression(x->left, false);
+        x->right = replaceExpression(x->right, false);
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNotNode>(node)) {
+        x->operand = replaceExpression(x->operand, false);
+    }
+    else if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        if (isBuiltinFunction(x->functionName)) {
+            //second @sref argument has to stay an identifier
+            if (!x->arguments.empty() && x->functionName != LENGTH_FUNCTION) {
+                x->arguments.at(0) = replaceExpression(x->arguments.at(0), false);
+            }
+            return node;
+        }
+        //resolve before arguments are replaced
+        FunctionDescr descr = findCallDescr(x, context.variables.at(functionName), context.function_descrs);
+        for (int i = 0; i < x->arguments.size(); i++) {
+            x->arguments.at(i) = replaceExpression(x->arguments.at(i), descr.params.at(i).second.getEnum() == TypeType::CHAR);
+        }
+        return evaluateCall(x, charContext);
+    }
+    return node;
+}
+
+shared_ptr<ASTNode> PureFunctionEvaluation::evaluateCall(const shared_ptr<FunctionCallNode>& call, bool charContext) {
+    FunctionDescr descr = findCallDescr(call, context.variables.at(functionName), context.function_descrs);
+    if (!pure.count(descr.address)) {
+        return call;
+    }
+
+    vector<int> arguments;
+    string key = descr.address;
+    for (const auto& argument : call->arguments) {
+        auto number = dynamic_pointer_cast<NumberNode>(argument);
+        if (number == nullptr) {
+            return call;
+        }
+        arguments.push_back(number->value);
+        key += " " + to_string(number->value);
+    }
+
+    if (!results.count(key)) {
+        Interpreter interpreter(context, definitions, STEP_BUDGET);
+        int value;
+        if (!interpreter.call(descr, arguments, value)) {
+            return call;
+        }
+        results[key] = value;
+    }
+
+    //byte stores of the call keep the low byte, no immediate outside of the byte range there
+    int value = results.at(key);
+    if (charContext && (value < 0 || value > 255)) {
+        return call;
+    }
+    if (value < 0) {
+        if (value == INT_MIN) {
+            return call;
+        }
+        return make_shared<ArithmeticNode>(ArithmeticType::SUBTRACT, make_shared<NumberNode>(0), make_shared<NumberNode>(-value));
+    }
+    return make_shared<NumberNode>(value);
+}
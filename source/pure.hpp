@@ -0,0 +1,31 @@
+#ifndef PURE_HPP
+#define PURE_HPP
+
+#include "interpreter.hpp"
+
+//f(3, 4) => 25: calls of pure functions (no @sref/@output, heap, arrays or impure calls) with
+//constant arguments are evaluated by the interpreter and replaced by their result
+class PureFunctionEvaluation {
+public:
+    explicit PureFunctionEvaluation(OptimizerContext&);
+    void run(vector<shared_ptr<ASTNode>>& ast);
+
+private:
+    //interpreter steps of one call
+    static const int STEP_BUDGET = 100000;
+
+    OptimizerContext& context;
+    unordered_map<string, shared_ptr<FunctionDefinitionNode>> definitions; //address -> definition
+    unordered_set<string> pure; //addresses
+    unordered_map<string, int> results; //address and arguments -> value
+    string functionName;
+    Type returnType;
+
+    void findPureFunctions();
+    bool isPureBody(const shared_ptr<FunctionDefinitionNode>&, unordered_set<string>& callees);
+    void replaceStatement(const shared_ptr<ASTNode>&);
+    shared_ptr<ASTNode> replaceExpression(const shared_ptr<ASTNode>&, bool charContext);
+    shared_ptr<ASTNode> evaluateCall(const shared_ptr<FunctionCallNode>&, bool charContext);
+};
+
+#endif //PURE_HPP
@@ -0,0 +1,169 @@
+#include "regalloc.hpp"
+
+#include <algorithm>
+
+LinearScanAllocator::LinearScanAllocator(const IRFunction& function) : function(function) {}
+
+unordered_map<string, string> LinearScanAllocator::allocate(const unordered_set<string>& candidates, const unordered_set<string>& parameters, const vector<string>& registers) {
+    vector<Interval> intervals = buildIntervals(candidates);
+    intervals.erase(remove_if(intervals.begin(), intervals.end(), [&](const Interval& interval) {
+        return parameters.count(interval.name) && interval.weight < 2;
+    }), intervals.end());
+    sort(intervals.begin(), intervals.end(), [](const Interval& a, const Interval& b) {
+        return a.start != b.start ? a.start < b.start : a.name < b.name;
+    });
+
+    unordered_map<string, string> result;
+    vector<string> free(registers.rbegin(), registers.rend());
+    vector<Interval> active;
+    for (const Interval& interval : intervals) {
+        //registers of intervals that ended before this one starts
+        for (auto it = active.begin(); it != active.end();) {
+            if (it->end < interval.start) {
+                free.push_back(result.at(it->name));
+                it = active.erase(it);
+            }
+            else {
+                it++;
+            }
+        }
+
+        if (!free.empty()) {
+            result[interval.name] = free.back();
+            free.pop_back();
+            active.push_back(interval);
+            continue;
+        }
+
+        //spill the cheapest, on equal weight the one that blocks a register longest
+        auto cheapest = min_element(active.begin(), active.end(), [](const Interval& a, const Interval& b) {
+            return a.weight != b.weight ? a.weight < b.weight : a.end > b.end;
+        });
+        if (cheapest == active.end() || cheapest->weight > interval.weight || (cheapest->weight == interval.weight && cheapest->end <= interval.end)) {
+            continue;
+        }
+        result[interval.name] = result.at(cheapest->name);
+        result.erase(cheapest->name);
+        active.erase(cheapest);
+        active.push_back(interval);
+    }
+    return result;
+}
+
+//larger slots first, then in interval order; variables without an interval (no use) get an own slot
+unordered_map<string, int> LinearScanAllocator::assignSlots(const unordered_map<string, int>& sizes, int& frameSize) {
+    unordered_set<string> candidates;
+    for (const auto& [name, size] : sizes) {
+        candidates.insert(name);
+    }
+    unordered_map<string, Interval> intervals;
+    for (const Interval& interval : buildIntervals(candidates)) {
+        intervals[interval.name] = interval;
+    }
+
+    vector<string> names(candidates.begin(), candidates.end());
+    sort(names.begin(), names.end(), [&](const string& a, const string& b) {
+        int startA = intervals.count(a) ? intervals.at(a).start : -1;
+        int startB = intervals.count(b) ? intervals.at(b).start : -1;
+        if (sizes.at(a) != sizes.at(b)) return sizes.at(a) > sizes.at(b);
+        return startA != startB ? startA < startB : a < b;
+    });
+
+    struct Slot {
+        int size;
+        int offset;
+        vector<Interval> occupants;
+    };
+    vector<Slot> slots;
+    unordered_map<string, int> result;
+    for (const string& name : names) {
+        int size = sizes.at(name);
+        Slot* slot = nullptr;
+        if (intervals.count(name)) {
+            const Interval& interval = intervals.at(name);
+            for (Slot& candidate : slots) {
+                bool overlaps = candidate.occupants.empty() || any_of(candidate.occupants.begin(), candidate.occupants.end(), [&](const Interval& other) {
+                    return other.start <= interval.end && interval.start <= other.end;
+                });
+                if (candidate.size == size && !overlaps) {
+                    slot = &candidate;
+                    break;
+                }
+            }
+        }
+        if (slot == nullptr) {
+            frameSize += size;
+            slots.push_back({size, frameSize, {}});
+            slot = &slots.back();
+        }
+        //an empty occupant list marks a slot of its own
+        if (intervals.count(name)) {
+            slot->occupants.push_back(intervals.at(name));
+        }
+        result[name] = slot->offset;
+    }
+    return result;
+}
+
+//one interval from the first to the last position the variable is live, positions count instructions in block order
+vector<LinearScanAllocator::Interval> LinearScanAllocator::buildIntervals(const unordered_set<string>& candidates) {
+    Liveness liveness = computeLiveness(function);
+    vector<int> depths = getLoopDepths();
+    unordered_map<string, Interval> intervals;
+    auto extend = [&](const string& name, int position, int weight) {
+        if (!candidates.count(name)) {
+            return;
+        }
+        if (!intervals.count(name)) {
+            intervals[name] = {name, position, position, 0};
+        }
+        Interval& interval = intervals.at(name);
+        interval.start = min(interval.start, position);
+        interval.end = max(interval.end, position);
+        interval.weight += weight;
+    };
+
+    int position = 0;
+    for (const BasicBlock& block : function.blocks) {
+        int weight = 1;
+        for (int i = 0; i < depths[block.id] && i < MAX_LOOP_DEPTH; i++) {
+            weight *= LOOP_WEIGHT;
+        }
+
+        int start = position;
+        for (const string& name : liveness.liveIn[block.id]) {
+            extend(name, start, 0);
+        }
+        for (const IRInstruction& instruction : block.instructions) {
+            for (const IROperand* use : instruction.uses()) {
+                extend(use->toString(), position, weight);
+            }
+            if (instruction.dest.isVariable()) {
+                extend(instruction.dest.toString(), position, weight);
+            }
+            position++;
+        }
+        for (const string& name : liveness.liveOut[block.id]) {
+            extend(name, position - 1, 0);
+        }
+    }
+
+    vector<Interval> result;
+    for (const auto& [name, interval] : intervals) {
+        result.push_back(interval);
+    }
+    return result;
+}
+
+//a jump back to an earlier block closes a loop over all blocks in between
+vector<int> LinearScanAllocator::getLoopDepths() {
+    vector<int> depths(function.blocks.size(), 0);
+    for (const BasicBlock& block : function.blocks) {
+        for (int successor : block.successors) {
+            if (successor <= block.id) {
+                for (int i = successor; i <= block.id; i++) depths[i]++;
+            }
+        }
+    }
+    return depths;
+}
@@ -0,0 +1,35 @@
+#ifndef REGALLOC_HPP
+#define REGALLOC_HPP
+
+#include "ir.hpp"
+
+//linear scan over live intervals of whole frame variables: a variable keeps one register over its
+//interval, when registers run out the interval with the lowest use weight stays in memory
+class LinearScanAllocator {
+public:
+    explicit LinearScanAllocator(const IRFunction&);
+    //variable -> register, parameters have to be loaded once and need more than one use
+    unordered_map<string, string> allocate(const unordered_set<string>& candidates, const unordered_set<string>& parameters, const vector<string>& registers);
+    //frame slots (offset below the frame base) of the variables in memory, variables that are never live
+    //at the same time share a slot of their size; frameSize is the total
+    unordered_map<string, int> assignSlots(const unordered_map<string, int>& sizes, int& frameSize);
+
+private:
+    //uses inside a loop count LOOP_WEIGHT times, up to MAX_LOOP_DEPTH loops deep
+    static const int LOOP_WEIGHT = 10;
+    static const int MAX_LOOP_DEPTH = 4;
+
+    struct Interval {
+        string name;
+        int start;
+        int end;
+        int weight;
+    };
+
+    const IRFunction& function;
+
+    vector<Interval> buildIntervals(const unordered_set<string>& candidates);
+    vector<int> getLoopDepths();
+};
+
+#endif //REGALLOC_HPP
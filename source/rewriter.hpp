@@ -25,6 +25,9 @@ public:
             return rewriteWhile(whileNode);
         } else if (auto forNode = dynamic_pointer_cast<ForNode>(node)) {
             return rewriteFor(forNode);
+        } else if (auto block = dynamic_pointer_cast<BlockNode>(node)) {
+            for (auto &stmt : block->body) stmt = rewrite(stmt);
+            return block;
         }
 
         return node;
@@ -239,24 +242,11 @@ private:
             stmt = rewrite(stmt);
         }
 
-        std::vector<std::shared_ptr<ASTNode>> transformed;
-
-        //transformed.push_back(std::make_shared<GotoNode>(endLabel));
-
-        node->body.push_back(std::make_shared<GotoNode>(startLabel));
-
-        std::vector<std::shared_ptr<ASTNode>> elseBlock;
-
-        transformed.push_back(std::make_shared<LabelNode>(startLabel));
-        transformed.push_back(std::make_shared<IfNode>(
-            node->condition, // Negate condition
-            node->body,
-            elseBlock
-            ));
-
-        transformed.push_back(std::make_shared<LabelNode>(endLabel));
+        for (auto &stmt : node->preheader) {
+            stmt = rewrite(stmt);
+        }
 
-        return std::make_shared<BlockNode>(transformed);
+        return rotateLoop(nullptr, node->guard ? node->guard : cloneNode(node->condition), node->preheader, node->condition, node->body, startLabel, endLabel);
     }
 
     std::shared_ptr<ASTNode> rewriteFor(std::shared_ptr<ForNode> node) {
@@ -267,23 +257,36 @@ private:
             stmt = rewrite(stmt);
         }
 
-        std::vector<std::shared_ptr<ASTNode>> transformed;
+        for (auto &stmt : node->preheader) {
+            stmt = rewrite(stmt);
+        }
+
+        node->body.push_back(rewrite(node->update));
 
-        //transformed.push_back(std::make_shared<GotoNode>(endLabel));
+        return rotateLoop(rewrite(node->init), node->guard ? node->guard : cloneNode(node->condition), node->preheader, node->condition, node->body, startLabel, endLabel);
+    }
 
-        std::vector<std::shared_ptr<ASTNode>> elseBlock;
+    // rotated loop: init; if (guard) { preheader; start: body; if (cond) goto start; } end:
+    // guard once, then only one conditional jump per iteration
+    std::shared_ptr<ASTNode> rotateLoop(std::shared_ptr<ASTNode> init, std::shared_ptr<ASTNode> guard,
+                                        const std::vector<std::shared_ptr<ASTNode>>& preheader,
+                                        std::shared_ptr<ASTNode> condition,
+                                        std::vector<std::shared_ptr<ASTNode>> body,
+                                        const std::string& startLabel, const std::string& endLabel) {
+        std::vector<std::shared_ptr<ASTNode>> transformed;
+        if (init) {
+            transformed.push_back(init);
+        }
 
-        node->body.push_back(rewrite(node->update));
-        node->body.push_back(std::make_shared<GotoNode>(startLabel));
-
-        transformed.push_back(rewrite(node->init));
-        transformed.push_back(std::make_shared<LabelNode>(startLabel));
-        transformed.push_back(std::make_shared<IfNode>(
-            node->condition, // Negate condition
-            node->body,
-            elseBlock
+        std::vector<std::shared_ptr<ASTNode>> loopBody = preheader;
+        loopBody.push_back(std::make_shared<LabelNode>(startLabel));
+        loopBody.insert(loopBody.end(), body.begin(), body.end());
+        loopBody.push_back(std::make_shared<IfNode>(
+            condition,
+            std::vector<std::shared_ptr<ASTNode>>{std::make_shared<GotoNode>(startLabel)}
             ));
 
+        transformed.push_back(std::make_shared<IfNode>(guard, loopBody));
         transformed.push_back(std::make_shared<LabelNode>(endLabel));
 
         return std::make_shared<BlockNode>(transformed);
@@ -0,0 +1,268 @@
+#include "specialize.hpp"
+
+#include <algorithm>
+
+FunctionSpecialization::FunctionSpecialization(OptimizerContext& context) : context(context) {}
+
+void FunctionSpecialization::run(vector<shared_ptr<ASTNode>>& ast) {
+    vector<shared_ptr<FunctionDefinitionNode>> functions;
+    for (const shared_ptr<ASTNode>& node : ast) {
+        if (auto function = dynamic_pointer_cast<FunctionDefinitionNode>(node)) {
+            definitions[findFunctionDescr(function, context.function_descrs).address] = function;
+            functions.push_back(function);
+        }
+    }
+
+    //call sites with constant int arguments, grouped by callee and constants
+    vector<Pattern> patterns;
+    unordered_map<string, int> patternIndex;
+    for (const auto& function : functions) {
+        const unordered_map<string, Type>& variables = context.variables.at(function->functionName);
+        for (const auto& stmt : function->body) {
+            visitNodes(stmt, [&](const shared_ptr<ASTNode>& node) {
+                auto call = dynamic_pointer_cast<FunctionCallNode>(node);
+                if (call == nullptr || isBuiltinFunction(call->functionName) || call->functionName == "main") {
+                    return;
+                }
+                FunctionDescr descr = findCallDescr(call, variables, context.function_descrs);
+                if (!definitions.count(descr.address)) {
+                    return;
+                }
+
+                vector<pair<int, int>> constants;
+                string key = descr.address;
+                for (int i = 0; i < call->arguments.size(); i++) {
+                    auto number = dynamic_pointer_cast<NumberNode>(call->arguments.at(i));
+                    if (number && descr.params.at(i).second.getEnum() == TypeType::INT) {
+                        constants.push_back({i, number->value});
+                        key += " " + to_string(i) + "=" + to_string(number->value);
+                    }
+                }
+                if (constants.empty()) {
+                    return;
+                }
+
+                if (!patternIndex.count(key)) {
+                    patternIndex[key] = patterns.size();
+                    patterns.push_back({descr.address, constants, {}});
+                }
+                patterns.at(patternIndex.at(key)).calls.push_back(call);
+            });
+        }
+    }
+
+    //most calls first
+    stable_sort(patterns.begin(), patterns.end(), [](const Pattern& a, const Pattern& b) {
+        return a.calls.size() > b.calls.size();
+    });
+
+    int budget = SPECIALIZE_BUDGET;
+    for (const Pattern& pattern : patterns) {
+        FunctionDescr descr;
+        for (const FunctionDescr& x : context.function_descrs) {
+            if (x.address == pattern.address) descr = x;
+        }
+        string name = getUniqueName(descr.name);
+
+        //only worth it if the constants fold something
+        int folded = 0;
+        shared_ptr<FunctionDefinitionNode> clone = specialize(pattern, name, folded);
+        int size = 0;
+        for (const auto& stmt : clone->body) {
+            size += countNodes(stmt);
+        }
+        if (folded == 0 || size > budget) {
+            continue;
+        }
+        budget -= size;
+
+        //the clone is a function of its own, with the constant parameters removed
+        FunctionDescr cloneDescr = {name, descr.type, {}, name};
+        unordered_set<int> removed;
+        for (const auto& [index, value] : pattern.constants) {
+            removed.insert(index);
+        }
+        for (int i = 0; i < descr.params.size(); i++) {
+            if (!removed.count(i)) cloneDescr.params.push_back(descr.params.at(i));
+        }
+        context.function_descrs.push_back(cloneDescr);
+        context.variables[name] = context.variables.at(descr.name);
+        definitions[name] = clone;
+        ast.push_back(clone);
+
+        for (const auto& call : pattern.calls) {
+            call->functionName = name;
+            for (int i = call->arguments.size() - 1; i >= 0; i--) {
+                if (removed.count(i)) call->arguments.erase(call->arguments.begin() + i);
+            }
+        }
+    }
+}
+
+//parameters that the body never writes are substituted, the others become initialized locals
+shared_ptr<FunctionDefinitionNode> FunctionSpecialization::specialize(const Pattern& pattern, const string& name, int& folded) {
+    const shared_ptr<FunctionDefinitionNode>& function = definitions.at(pattern.address);
+    shared_ptr<FunctionDefinitionNode> clone = static_pointer_cast<FunctionDefinitionNode>(function->clone());
+    clone->functionName = name;
+
+    SideEffects effects;
+    collectSideEffects(function->body, effects);
+    vector<shared_ptr<ASTNode>> body;
+    unordered_set<int> removed;
+    for (const auto& [index, value] : pattern.constants) {
+        const string& parameter = function->parameters.at(index).second;
+        removed.insert(index);
+        if (effects.writtenVariables.count(parameter)) {
+            body.push_back(make_shared<VariableDeclarationNode>(Type(TypeType::INT), parameter, make_shared<NumberNode>(value)));
+        }
+        else {
+            for (auto& stmt : clone->body) {
+                stmt = substituteVariable(stmt, parameter, make_shared<NumberNode>(value));
+            }
+        }
+    }
+    body.insert(body.end(), clone->body.begin(), clone->body.end());
+    clone->body = body;
+
+    vector<pair<Type, string>> parameters;
+    for (int i = 0; i < function->parameters.size(); i++) {
+        if (!removed.count(i)) parameters.push_back(function->parameters.at(i));
+    }
+    clone->parameters = parameters;
+
+    folded = 0;
+    for (int round = 0; round < 3; round++) {
+        int changes = simplifyBlock(clone->body) + propagateConstants(clone->body, clone->parameters);
+        if (changes == 0) {
+            break;
+        }
+        folded += changes;
+    }
+    return clone;
+}
+
+//folds arithmetic and drops branches and loops with constant conditions, returns the number of changes
+int FunctionSpecialization::simplifyBlock(vector<shared_ptr<ASTNode>>& block) {
+    int changes = 0;
+    for (shared_ptr<ASTNode>& node : block) {
+        int size = countNodes(node);
+        node = foldConstants(node);
+        if (countNodes(node) < size) {
+            changes++;
+        }
+
+        bool value;
+        if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+            if (isConstantCondition(x->condition, value)) {
+                node = make_shared<BlockNode>(value ? x->thenBlock : x->elseBlock);
+                changes++;
+            }
+        }
+        else if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+            if (isConstantCondition(x->condition, value) && !value) {
+                node = make_shared<BlockNode>(vector<shared_ptr<ASTNode>>{});
+                changes++;
+            }
+        }
+        else if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+            if (isConstantCondition(x->condition, value) && !value) {
+                node = make_shared<BlockNode>(vector<shared_ptr<ASTNode>>{x->init});
+                changes++;
+            }
+        }
+
+        if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+            changes += simplifyBlock(x->thenBlock) + simplifyBlock(x->elseBlock);
+        }
+        else if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+            changes += simplifyBlock(x->body);
+        }
+        else if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+            changes += simplifyBlock(x->body);
+        }
+        else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+            changes += simplifyBlock(x->body);
+        }
+    }
+    return changes;
+}
+
+//int x = 5; at function level, never written again and not read before => reads of x become 5
+int FunctionSpecialization::propagateConstants(vector<shared_ptr<ASTNode>>& body, const vector<pair<Type, string>>& parameters) {
+    SideEffects effects;
+    collectSideEffects(body, effects);
+    if (effects.hasLabel) {
+        return 0;
+    }
+
+    auto countReads = [&](const string& name, int from) {
+        int count = 0;
+        for (int i = from; i < body.size(); i++) {
+            visitNodes(body[i], [&](const shared_ptr<ASTNode>& node) {
+                auto x = dynamic_pointer_cast<IdentifierNode>(node);
+                if (x && x->name == name && x->index == nullptr) count++;
+            });
+        }
+        return count;
+    };
+
+    int changes = 0;
+    for (int k = 0; k < body.size(); k++) {
+        auto declaration = dynamic_pointer_cast<VariableDeclarationNode>(body[k]);
+        if (declaration == nullptr || declaration->varType.getEnum() != TypeType::INT || !dynamic_pointer_cast<NumberNode>(declaration->value)) {
+            continue;
+        }
+        const string& name = declaration->varName;
+
+        bool written = false;
+        for (const auto& stmt : body) {
+            visitNodes(stmt, [&](const shared_ptr<ASTNode>& node) {
+                auto x = dynamic_pointer_cast<AssignmentNode>(node);
+                if (x && x->variable->name == name && x->variable->index == nullptr) written = true;
+                auto y = dynamic_pointer_cast<VariableDeclarationNode>(node);
+                if (y && y != declaration && y->varName == name) written = true;
+            });
+        }
+        for (const auto& [type, parameter] : parameters) {
+            written = written || parameter == name;
+        }
+        if (written) {
+            continue;
+        }
+        unordered_set<string> readsBefore;
+        for (int i = 0; i < k; i++) {
+            collectStatementReads(body[i], readsBefore);
+        }
+        if (readsBefore.count(name)) {
+            continue;
+        }
+
+        int before = countReads(name, k + 1);
+        for (int i = k + 1; i < body.size(); i++) {
+            body[i] = substituteVariable(body[i], name, declaration->value);
+        }
+        if (countReads(name, k + 1) < before) {
+            changes++;
+        }
+    }
+    return changes;
+}
+
+//name_N like the analyzer numbers overloads, skipping names and addresses in use
+string FunctionSpecialization::getUniqueName(const string& name) {
+    int count = 0;
+    for (const FunctionDescr& x : context.function_descrs) {
+        if (x.name == name) count++;
+    }
+    while (true) {
+        string candidate = name + "_" + to_string(count);
+        bool used = false;
+        for (const FunctionDescr& x : context.function_descrs) {
+            used = used || x.name == candidate || x.address == candidate;
+        }
+        if (!used) {
+            return candidate;
+        }
+        count++;
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef SPECIALIZE_HPP
+#define SPECIALIZE_HPP
+
+#include "optimizer.hpp"
+
+//f(x, 10) => f_N(x): clone of f with the constant parameter propagated and folded,
+//for the most frequent constant argument patterns within a size budget
+class FunctionSpecialization {
+public:
+    explicit FunctionSpecialization(OptimizerContext&);
+    void run(vector<shared_ptr<ASTNode>>& ast);
+
+private:
+    //AST nodes of all clones together
+    static const int SPECIALIZE_BUDGET = 300;
+
+    //constant int arguments (index -> value) of one callee, shared by calls
+    struct Pattern {
+        string address;
+        vector<pair<int, int>> constants;
+        vector<shared_ptr<FunctionCallNode>> calls;
+    };
+
+    OptimizerContext& context;
+    unordered_map<string, shared_ptr<FunctionDefinitionNode>> definitions; //address -> definition
+
+    shared_ptr<FunctionDefinitionNode> specialize(const Pattern&, const string& name, int& folded);
+    int simplifyBlock(vector<shared_ptr<ASTNode>>&);
+    int propagateConstants(vector<shared_ptr<ASTNode>>&, const vector<pair<Type, string>>& parameters);
+    string getUniqueName(const string& name);
+};
+
+#endif //SPECIALIZE_HPP
@@ -0,0 +1,207 @@
+#include "ssa.hpp"
+
+#include <algorithm>
+
+SSABuilder::SSABuilder(IRFunction& function) : function(function) {}
+
+void SSABuilder::construct() {
+    if (function.isSSA) {
+        return;
+    }
+    function.computeEdges();
+    computeDominators();
+    computeFrontiers();
+    insertPhis();
+
+    //version 0 is the value on entry: parameters and not yet assigned variables
+    versionNum.clear();
+    versionStack.clear();
+    for (const auto& [name, type] : function.variables) {
+        if (isLocalIRVariable(name)) {
+            versionNum[name] = 1;
+            versionStack[name] = {0};
+        }
+    }
+    rename(0);
+    function.isSSA = true;
+}
+
+//Cooper, Harvey, Kennedy: iterate over the reverse postorder until the immediate dominators are stable
+void SSABuilder::computeDominators() {
+    vector<int> order = function.reversePostorder();
+    vector<int> position(function.blocks.size(), -1);
+    for (int i = 0; i < order.size(); i++) {
+        position[order[i]] = i;
+    }
+
+    dominators.assign(function.blocks.size(), -1);
+    dominators[0] = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int block : order) {
+            if (block == 0) {
+                continue;
+            }
+            int dominator = -1;
+            for (int predecessor : function.blocks.at(block).predecessors) {
+                if (dominators[predecessor] == -1) {
+                    continue;
+                }
+                dominator = dominator == -1 ? predecessor : intersect(predecessor, dominator, position);
+            }
+            if (dominators[block] != dominator) {
+                dominators[block] = dominator;
+                changed = true;
+            }
+        }
+    }
+
+    children.assign(function.blocks.size(), {});
+    for (int block : order) {
+        if (block != 0) children[dominators[block]].push_back(block);
+    }
+}
+
+int SSABuilder::intersect(int a, int b, const vector<int>& position) const {
+    while (a != b) {
+        while (position[a] > position[b]) a = dominators[a];
+        while (position[b] > position[a]) b = dominators[b];
+    }
+    return a;
+}
+
+void SSABuilder::computeFrontiers() {
+    frontiers.assign(function.blocks.size(), {});
+    for (const BasicBlock& block : function.blocks) {
+        if (block.predecessors.size() < 2) {
+            continue;
+        }
+        for (int predecessor : block.predecessors) {
+            int runner = predecessor;
+            while (runner != dominators[block.id]) {
+                vector<int>& frontier = frontiers[runner];
+                if (find(frontier.begin(), frontier.end(), block.id) == frontier.end()) {
+                    frontier.push_back(block.id);
+                }
+                runner = dominators[runner];
+            }
+        }
+    }
+}
+
+//semi-pruned: variables that are read in a block before being assigned there
+void SSABuilder::insertPhis() {
+    unordered_set<string> globals;
+    unordered_map<string, vector<int>> definitionBlocks;
+    for (const BasicBlock& block : function.blocks) {
+        unordered_set<string> assigned;
+        for (const IRInstruction& instruction : block.instructions) {
+            for (const IROperand* use : instruction.uses()) {
+                if (isLocalIRVariable(use->name) && !assigned.count(use->name)) globals.insert(use->name);
+            }
+            if (instruction.dest.isVariable() && isLocalIRVariable(instruction.dest.name)) {
+                assigned.insert(instruction.dest.name);
+                definitionBlocks[instruction.dest.name].push_back(block.id);
+            }
+        }
+    }
+
+    //sorted for a stable phi order
+    vector<string> names(globals.begin(), globals.end());
+    sort(names.begin(), names.end());
+    for (const string& name : names) {
+        vector<bool> hasPhi(function.blocks.size(), false);
+        vector<int> worklist = definitionBlocks[name];
+        while (!worklist.empty()) {
+            int block = worklist.back();
+            worklist.pop_back();
+            for (int frontier : frontiers[block]) {
+                if (hasPhi[frontier]) {
+                    continue;
+                }
+                hasPhi[frontier] = true;
+                BasicBlock& target = function.blocks.at(frontier);
+                IRInstruction phi = {IROpcode::PHI, IROperand::variable(name)};
+                phi.type = function.variables.at(name);
+                for (int predecessor : target.predecessors) {
+                    phi.operands.push_back(IROperand::variable(name));
+                    phi.blocks.push_back(predecessor);
+                }
+                target.instructions.insert(target.instructions.begin(), phi);
+                worklist.push_back(frontier);
+            }
+        }
+    }
+}
+
+void SSABuilder::rename(int block) {
+    vector<string> pushed;
+    for (IRInstruction& instruction : function.blocks.at(block).instructions) {
+        if (instruction.opcode != IROpcode::PHI) {
+            for (IROperand* use : instruction.usesMutable()) {
+                if (isLocalIRVariable(use->name)) use->version = versionStack.at(use->name).back();
+            }
+        }
+        if (instruction.dest.isVariable() && isLocalIRVariable(instruction.dest.name)) {
+            const string& name = instruction.dest.name;
+            instruction.dest.version = versionNum[name]++;
+            versionStack[name].push_back(instruction.dest.version);
+            pushed.push_back(name);
+        }
+    }
+
+    for (int successor : function.blocks.at(block).successors) {
+        for (IRInstruction& phi : function.blocks.at(successor).instructions) {
+            if (phi.opcode != IROpcode::PHI) {
+                break;
+            }
+            for (int i = 0; i < phi.blocks.size(); i++) {
+                if (phi.blocks[i] == block) {
+                    phi.operands[i].version = versionStack.at(phi.operands[i].name).back();
+                }
+            }
+        }
+    }
+
+    for (int child : children[block]) {
+        rename(child);
+    }
+    for (const string& name : pushed) {
+        versionStack[name].pop_back();
+    }
+}
+
+void SSABuilder::destruct() {
+    if (!function.isSSA) {
+        return;
+    }
+    //copies are collected first, a block can be its own predecessor
+    vector<vector<IRInstruction>> copies(function.blocks.size());
+    for (BasicBlock& block : function.blocks) {
+        for (IRInstruction& phi : block.instructions) {
+            if (phi.opcode != IROpcode::PHI) {
+                break;
+            }
+            //a fresh variable per phi cannot interfere with other copies (no lost copies, no swaps)
+            IROperand copy = IROperand::variable("$phi" + to_string(copyNum++));
+            function.variables[copy.name] = phi.type;
+            for (int i = 0; i < phi.blocks.size(); i++) {
+                IRInstruction move = {IROpcode::COPY, copy, {phi.operands[i]}};
+                move.type = phi.type;
+                copies[phi.blocks[i]].push_back(move);
+            }
+            phi.opcode = IROpcode::COPY;
+            phi.operands = {copy};
+            phi.blocks.clear();
+        }
+    }
+
+    for (BasicBlock& block : function.blocks) {
+        for (IRInstruction& move : copies[block.id]) {
+            move.statement = block.instructions.back().statement;
+        }
+        block.instructions.insert(block.instructions.end() - 1, copies[block.id].begin(), copies[block.id].end());
+    }
+    function.isSSA = false;
+}
@@ -0,0 +1,33 @@
+#ifndef SSA_HPP
+#define SSA_HPP
+
+#include "ir.hpp"
+
+//SSA form for the local variables of an IR function: phis at the iterated dominance frontiers of the
+//definitions (only for variables live across blocks), renaming along the dominator tree
+class SSABuilder {
+public:
+    explicit SSABuilder(IRFunction&);
+    void construct();
+    //phis become copies through a fresh variable per phi at the end of the predecessors
+    void destruct();
+
+    const vector<int>& getDominators() const { return dominators; }
+
+private:
+    IRFunction& function;
+    vector<int> dominators; //immediate dominator per block, the entry dominates itself
+    vector<vector<int>> frontiers;
+    vector<vector<int>> children; //dominator tree
+    unordered_map<string, int> versionNum;
+    unordered_map<string, vector<int>> versionStack;
+    int copyNum = 0;
+
+    void computeDominators();
+    void computeFrontiers();
+    void insertPhis();
+    void rename(int block);
+    int intersect(int a, int b, const vector<int>& order) const;
+};
+
+#endif //SSA_HPP
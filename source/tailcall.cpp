@@ -0,0 +1,129 @@
+#include "tailcall.hpp"
+
+TailCallElimination::TailCallElimination(OptimizerContext& context) : context(context) {}
+
+void TailCallElimination::run(const shared_ptr<FunctionDefinitionNode>& function) {
+    this->function = function;
+    descr = findFunctionDescr(function, context.function_descrs);
+    entryLabel.clear();
+
+    processBlock(function->body, true);
+    if (!entryLabel.empty()) {
+        function->body.insert(function->body.begin(), make_shared<LabelNode>(entryLabel));
+    }
+}
+
+//isTail: the end of the block returns from the function
+void TailCallElimination::processBlock(vector<shared_ptr<ASTNode>>& block, bool isTail) {
+    for (int i = 0; i < block.size(); i++) {
+        shared_ptr<ASTNode>& node = block[i];
+        bool last = i + 1 == block.size();
+
+        if (auto x = dynamic_pointer_cast<ReturnValueNode>(node)) {
+            auto call = dynamic_pointer_cast<FunctionCallNode>(x->value);
+            if (call && !isBuiltinFunction(call->functionName)) {
+                processTailCall(node, call, true);
+            }
+        }
+        else if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+            //void functions: 'f(...);' followed by return or the end of the function
+            bool followedByReturn = (last && isTail) || (!last && dynamic_pointer_cast<ReturnNode>(block[i + 1]));
+            if (descr.type.getEnum() == TypeType::VOID && followedByReturn && !isBuiltinFunction(x->functionName)) {
+                processTailCall(node, x, false);
+            }
+        }
+        else if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+            processBlock(x->thenBlock, isTail && last);
+            processBlock(x->elseBlock, isTail && last);
+        }
+        else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+            processBlock(x->body, isTail && last);
+        }
+        else if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+            processBlock(x->body, false);
+        }
+        else if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+            processBlock(x->body, false);
+        }
+    }
+}
+
+bool TailCallElimination::processTailCall(shared_ptr<ASTNode>& node, const shared_ptr<FunctionCallNode>& call, bool returnsValue) {
+    FunctionDescr callee = findCallDescr(call, context.variables.at(function->functionName), context.function_descrs);
+
+    //self recursion becomes a loop
+    if (callee.address == descr.address) {
+        if (entryLabel.empty()) {
+            entryLabel = "tailcall" + to_string(context.temporaryNum++);
+        }
+        vector<shared_ptr<ASTNode>> statements = reassignParameters(call);
+        statements.push_back(make_shared<GotoNode>(entryLabel));
+        node = make_shared<BlockNode>(statements);
+        return true;
+    }
+
+    //the caller of main does not pop parameters, the callee must leave the stack like this function
+    if (function->functionName == "main" || usesRegisterArguments(callee) != usesRegisterArguments(descr)) {
+        return false;
+    }
+    //register arguments: the callee may only clobber registers our caller does not expect back
+    if (usesRegisterArguments(callee) ? getClobberedRegisters(callee) > getClobberedRegisters(descr) : getParamSize(callee) != getParamSize(descr)) {
+        return false;
+    }
+    if (returnsValue ? callee.type.getEnum() != descr.type.getEnum() : callee.type.getEnum() != TypeType::VOID) {
+        return false;
+    }
+    call->isTailCall = true;
+    return true;
+}
+
+//arguments that read an already reassigned parameter (or call functions) go through temporaries,
+//assigned backwards like the generator pushes arguments
+vector<shared_ptr<ASTNode>> TailCallElimination::reassignParameters(const shared_ptr<FunctionCallNode>& call) {
+    bool hasCall = false;
+    for (const auto& argument : call->arguments) {
+        visitNodes(argument, [&](const shared_ptr<ASTNode>& node) {
+            auto x = dynamic_pointer_cast<FunctionCallNode>(node);
+            if (x && !isBuiltinFunction(x->functionName)) hasCall = true;
+        });
+    }
+
+    vector<shared_ptr<ASTNode>> temporaries;
+    vector<shared_ptr<ASTNode>> assignments;
+    unordered_set<string> reassigned;
+    for (int i = descr.params.size() - 1; i >= 0; i--) {
+        const auto& [name, type] = descr.params.at(i);
+        const shared_ptr<ASTNode>& argument = call->arguments.at(i);
+        auto identifier = dynamic_pointer_cast<IdentifierNode>(argument);
+        if (identifier && identifier->index == nullptr && identifier->name == name) {
+            continue;
+        }
+
+        unordered_set<string> reads;
+        collectReadVariables(argument, reads);
+        bool conflict = hasCall;
+        for (const string& read : reads) {
+            conflict = conflict || reassigned.count(read);
+        }
+
+        shared_ptr<ASTNode> value = argument;
+        if (conflict) {
+            string temporary = context.newTemporary(function->functionName, "tail_", type);
+            temporaries.push_back(make_shared<AssignmentNode>(make_shared<IdentifierNode>(temporary), argument));
+            value = make_shared<IdentifierNode>(temporary);
+        }
+        assignments.push_back(make_shared<AssignmentNode>(make_shared<IdentifierNode>(name), value));
+        reassigned.insert(name);
+    }
+
+    temporaries.insert(temporaries.end(), assignments.begin(), assignments.end());
+    return temporaries;
+}
+
+int TailCallElimination::getParamSize(const FunctionDescr& descr) {
+    int size = 0;
+    for (const auto& [name, type] : descr.params) {
+        size += type.size();
+    }
+    return size;
+}
@@ -0,0 +1,25 @@
+#ifndef TAILCALL_HPP
+#define TAILCALL_HPP
+
+#include "optimizer.hpp"
+
+//return f(...) in f => parameter reassignment and a jump to the function entry,
+//other tail calls with the same parameter size and return type are marked to reuse the frame
+class TailCallElimination {
+public:
+    explicit TailCallElimination(OptimizerContext&);
+    void run(const shared_ptr<FunctionDefinitionNode>&);
+
+private:
+    OptimizerContext& context;
+    shared_ptr<FunctionDefinitionNode> function;
+    FunctionDescr descr;
+    string entryLabel;
+
+    void processBlock(vector<shared_ptr<ASTNode>>&, bool isTail);
+    bool processTailCall(shared_ptr<ASTNode>& node, const shared_ptr<FunctionCallNode>&, bool returnsValue);
+    vector<shared_ptr<ASTNode>> reassignParameters(const shared_ptr<FunctionCallNode>&);
+    static int getParamSize(const FunctionDescr&);
+};
+
+#endif //TAILCALL_HPP
@@ -48,6 +48,9 @@ KeywordType toKeywordType(string name)
     if(name == "for") {
         return KeywordType::FOR;
     }
+    if(name == "inline") {
+        return KeywordType::INLINE;
+    }
 
     return KeywordType::TYPE;
 }
@@ -43,6 +43,7 @@ const unordered_set<string> KEYWORD_SET = {
     "while",
     "for",
     "goto",
+    "inline",
 };
 
 enum class KeywordType {
@@ -52,6 +53,7 @@ enum class KeywordType {
     ELSE,
     WHILE,
     FOR,
+    INLINE,
 };
 
 enum class NumberType {
@@ -0,0 +1,297 @@
+#include "unroll.hpp"
+
+#include <limits>
+
+LoopUnroller::LoopUnroller(OptimizerContext& context) : context(context) {}
+
+void LoopUnroller::run(const shared_ptr<FunctionDefinitionNode>& function) {
+    this->function = function;
+    processBlock(function->body);
+}
+
+//inner loops first, a completely unrolled inner loop counts with its copies
+void LoopUnroller::processBlock(vector<shared_ptr<ASTNode>>& block) {
+    for (shared_ptr<ASTNode>& node : block) {
+        if (auto x = dynamic_pointer_cast<ForNode>(node)) {
+            processBlock(x->body);
+            node = unrollLoop(x);
+        }
+        else if (auto x = dynamic_pointer_cast<WhileNode>(node)) {
+            processBlock(x->body);
+        }
+        else if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+            processBlock(x->thenBlock);
+            processBlock(x->elseBlock);
+        }
+        else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+            processBlock(x->body);
+        }
+    }
+}
+
+shared_ptr<ASTNode> LoopUnroller::unrollLoop(const shared_ptr<ForNode>& loop) {
+    CountedLoop counted;
+    if (!analyzeLoop(loop, counted)) {
+        return loop;
+    }
+
+    int bodySize = 0;
+    for (const auto& stmt : loop->body) {
+        bodySize += countNodes(stmt);
+    }
+    bodySize = max(bodySize, 1);
+
+    auto start = dynamic_pointer_cast<NumberNode>(dynamic_pointer_cast<VariableDeclarationNode>(loop->init)->value);
+    auto end = dynamic_pointer_cast<NumberNode>(counted.bound);
+    if (start && end) {
+        int tripCount = getTripCount(start->value, end->value, counted, bodySize);
+        if (tripCount >= 0) {
+            return unrollCompletely(loop, counted, start->value, tripCount);
+        }
+    }
+
+    //copies of inner loops cost more than the saved loop control
+    if (containsLoop(loop->body)) {
+        return loop;
+    }
+    return unrollPartially(loop, counted, bodySize);
+}
+
+//int i = a; i op bound; i = i + c with invariant bound and no writes to i in the body
+bool LoopUnroller::analyzeLoop(const shared_ptr<ForNode>& loop, CountedLoop& counted) {
+    auto init = dynamic_pointer_cast<VariableDeclarationNode>(loop->init);
+    if (init == nullptr || init->varType.getEnum() != TypeType::INT || !loop->preheader.empty() || loop->guard != nullptr) {
+        return false;
+    }
+    counted.counter = init->varName;
+    counted.step = getCounterStep(loop->update, counted.counter);
+    if (counted.step == 0) {
+        return false;
+    }
+
+    auto condition = dynamic_pointer_cast<LogicalNode>(loop->condition);
+    if (condition == nullptr || condition->logicalType == LogicalType::AND || condition->logicalType == LogicalType::OR) {
+        return false;
+    }
+    auto isCounter = [&](const shared_ptr<ASTNode>& node) {
+        auto identifier = dynamic_pointer_cast<IdentifierNode>(node);
+        return identifier && identifier->name == counted.counter && identifier->index == nullptr;
+    };
+    if (isCounter(condition->left)) {
+        counted.compare = condition->logicalType;
+        counted.bound = condition->right;
+    }
+    else if (isCounter(condition->right)) {
+        counted.compare = mirrorCompare(condition->logicalType);
+        counted.bound = condition->left;
+    }
+    else {
+        return false;
+    }
+
+    SideEffects loopEffects;
+    collectSideEffects(static_pointer_cast<ASTNode>(loop), loopEffects);
+    SideEffects bodyEffects;
+    collectSideEffects(loop->body, bodyEffects);
+    //copies of labels would be duplicate definitions
+    if (loopEffects.hasLabel || bodyEffects.writtenVariables.count(counted.counter)) {
+        return false;
+    }
+
+    if (dynamic_pointer_cast<NumberNode>(counted.bound)) {
+        return true;
+    }
+    auto bound = dynamic_pointer_cast<IdentifierNode>(counted.bound);
+    return bound && bound->index == nullptr && !isMemoryAlias(bound->name) && !SKIP_IDENT_NAMES.count(bound->name)
+        && !loopEffects.writtenVariables.count(bound->name);
+}
+
+//-1 if the copies would exceed the budget or the counter leaves the int range
+int LoopUnroller::getTripCount(long long start, long long end, const CountedLoop& counted, int bodySize) {
+    int tripCount = 0;
+    for (long long i = start; compare(i, end, counted.compare); i += counted.step) {
+        tripCount++;
+        if (static_cast<long long>(tripCount) * bodySize > context.options.unrollBudget
+            || i + counted.step > numeric_limits<int32_t>::max() || i + counted.step < numeric_limits<int32_t>::min()) {
+            return -1;
+        }
+    }
+    return tripCount;
+}
+
+shared_ptr<ASTNode> LoopUnroller::unrollCompletely(const shared_ptr<ForNode>& loop, const CountedLoop& counted, int start, int tripCount) {
+    //constants replace the counter if every value fits a char immediate, otherwise the counter is kept and updated between the copies
+    long long last = start + static_cast<long long>(tripCount - 1) * counted.step;
+    bool substitute = tripCount == 0 || (min<long long>(start, last) >= 0 && max<long long>(start, last) <= numeric_limits<uint8_t>::max());
+
+    vector<shared_ptr<ASTNode>> statements;
+    if (!substitute) {
+        statements.push_back(loop->init);
+    }
+    for (int k = 0; k < tripCount; k++) {
+        auto value = make_shared<NumberNode>(start + k * counted.step);
+        for (const auto& stmt : loop->body) {
+            shared_ptr<ASTNode> copy = cloneNode(stmt);
+            statements.push_back(substitute ? substituteVariable(copy, counted.counter, value) : copy);
+        }
+        if (!substitute) {
+            statements.push_back(cloneNode(loop->update));
+        }
+    }
+
+    //final counter value, if it is read after the loop
+    if (substitute) {
+        unordered_set<string> outsideReads;
+        for (const auto& stmt : function->body) {
+            collectStatementReads(stmt, outsideReads, loop.get());
+        }
+        if (outsideReads.count(counted.counter)) {
+            statements.push_back(make_shared<VariableDeclarationNode>(Type(TypeType::INT), counted.counter, make_shared<NumberNode>(start + tripCount * counted.step)));
+        }
+    }
+    return make_shared<BlockNode>(statements);
+}
+
+//for (i = a; i < n - (f-1)*c; i = i + f*c) { body(i) ... body(i + (f-1)*c) } while (i < n) { body(i); i = i + c; }
+shared_ptr<ASTNode> LoopUnroller::unrollPartially(const shared_ptr<ForNode>& loop, const CountedLoop& counted, int bodySize) {
+    bool upwards = counted.step > 0 && (counted.compare == LogicalType::LESS_THAN || counted.compare == LogicalType::LESS_EQUAL);
+    bool downwards = counted.step < 0 && (counted.compare == LogicalType::GREATER_THAN || counted.compare == LogicalType::GREATER_EQUAL);
+    if (!upwards && !downwards) {
+        return loop;
+    }
+
+    //every copy saves the loop control but pays for i + k, arr[i] alone is left to the strength reduction
+    int uses = 0;
+    int indexUses = 0;
+    for (const auto& stmt : loop->body) {
+        countCounterUses(stmt, counted.counter, uses, indexUses);
+    }
+    if (uses * OFFSET_COST >= LOOP_CONTROL_COST || (uses > 0 && uses == indexUses)) {
+        return loop;
+    }
+
+    int factor = context.options.unrollFactor;
+    while (factor > 1 && factor * bodySize > context.options.unrollBudget) {
+        factor--;
+    }
+    if (factor < 2) {
+        return loop;
+    }
+
+    long long offset = static_cast<long long>(factor - 1) * counted.step;
+    shared_ptr<ASTNode> mainBound;
+    if (auto end = dynamic_pointer_cast<NumberNode>(counted.bound)) {
+        long long value = end->value - offset;
+        if (value > numeric_limits<int32_t>::max() || value < numeric_limits<int32_t>::min()) {
+            return loop;
+        }
+        mainBound = make_shared<NumberNode>(value);
+    }
+    else {
+        mainBound = make_shared<ArithmeticNode>(ArithmeticType::SUBTRACT, cloneNode(counted.bound), make_shared<NumberNode>(offset));
+    }
+
+    vector<shared_ptr<ASTNode>> mainBody;
+    for (int k = 0; k < factor; k++) {
+        auto value = make_shared<ArithmeticNode>(ArithmeticType::ADD, make_shared<IdentifierNode>(counted.counter), make_shared<NumberNode>(k * counted.step));
+        for (const auto& stmt : loop->body) {
+            shared_ptr<ASTNode> copy = cloneNode(stmt);
+            mainBody.push_back(k == 0 ? copy : substituteVariable(copy, counted.counter, value));
+        }
+    }
+
+    auto mainLoop = make_shared<ForNode>(loop->init,
+        make_shared<LogicalNode>(counted.compare, make_shared<IdentifierNode>(counted.counter), mainBound),
+        make_shared<AssignmentNode>(make_shared<IdentifierNode>(counted.counter),
+            make_shared<ArithmeticNode>(ArithmeticType::ADD, make_shared<IdentifierNode>(counted.counter), make_shared<NumberNode>(factor * counted.step))),
+        mainBody);
+
+    vector<shared_ptr<ASTNode>> remainderBody = loop->body;
+    remainderBody.push_back(loop->update);
+    auto remainderLoop = make_shared<WhileNode>(loop->condition, remainderBody);
+
+    return make_shared<BlockNode>(vector<shared_ptr<ASTNode>>{mainLoop, remainderLoop});
+}
+
+//indexUses: arr[i] with exactly the counter as index
+void LoopUnroller::countCounterUses(const shared_ptr<ASTNode>& node, const string& counter, int& uses, int& indexUses) {
+    if (node == nullptr) {
+        return;
+    }
+    auto countBlock = [&](const vector<shared_ptr<ASTNode>>& block) {
+        for (const auto& stmt : block) countCounterUses(stmt, counter, uses, indexUses);
+    };
+
+    if (auto x = dynamic_pointer_cast<IdentifierNode>(node)) {
+        auto index = dynamic_pointer_cast<IdentifierNode>(x->index);
+        if (index && index->name == counter && index->index == nullptr) {
+            indexUses++;
+        }
+        if (x->name == counter && x->index == nullptr) {
+            uses++;
+        }
+        countCounterUses(x->index, counter, uses, indexUses);
+    }
+    else if (auto x = dynamic_pointer_cast<VariableDeclarationNode>(node)) {
+        countCounterUses(x->value, counter, uses, indexUses);
+    }
+    else if (auto x = dynamic_pointer_cast<AssignmentNode>(node)) {
+        countCounterUses(x->variable, counter, uses, indexUses);
+        countCounterUses(x->expression, counter, uses, indexUses);
+    }
+    else if (auto x = dynamic_pointer_cast<ArrayDeclarationNode>(node)) {
+        countBlock(x->arrayValues);
+    }
+    else if (auto x = dynamic_pointer_cast<ReturnValueNode>(node)) {
+        countCounterUses(x->value, counter, uses, indexUses);
+    }
+    else if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+        countCounterUses(x->condition, counter, uses, indexUses);
+        countBlock(x->thenBlock);
+        countBlock(x->elseBlock);
+    }
+    else if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+        countBlock(x->body);
+    }
+    else if (auto x = dynamic_pointer_cast<ArithmeticNode>(node)) {
+        countCounterUses(x->left, counter, uses, indexUses);
+        countCounterUses(x->right, counter, uses, indexUses);
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNode>(node)) {
+        countCounterUses(x->left, counter, uses, indexUses);
+        countCounterUses(x->right, counter, uses, indexUses);
+    }
+    else if (auto x = dynamic_pointer_cast<LogicalNotNode>(node)) {
+        countCounterUses(x->operand, counter, uses, indexUses);
+    }
+    else if (auto x = dynamic_pointer_cast<FunctionCallNode>(node)) {
+        countBlock(x->arguments);
+    }
+}
+
+bool LoopUnroller::compare(long long a, long long b, LogicalType logical) {
+    switch (logical) {
+        case LogicalType::EQUAL: return a == b;
+        case LogicalType::NOT_EQUAL: return a != b;
+        case LogicalType::LESS_THAN: return a < b;
+        case LogicalType::GREATER_THAN: return a > b;
+        case LogicalType::LESS_EQUAL: return a <= b;
+        case LogicalType::GREATER_EQUAL: return a >= b;
+        default: return false;
+    }
+}
+
+bool LoopUnroller::containsLoop(const vector<shared_ptr<ASTNode>>& block) {
+    for (const auto& node : block) {
+        if (dynamic_pointer_cast<ForNode>(node) || dynamic_pointer_cast<WhileNode>(node)) {
+            return true;
+        }
+        if (auto x = dynamic_pointer_cast<IfNode>(node)) {
+            if (containsLoop(x->thenBlock) || containsLoop(x->elseBlock)) return true;
+        }
+        if (auto x = dynamic_pointer_cast<BlockNode>(node)) {
+            if (containsLoop(x->body)) return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,41 @@
+#ifndef UNROLL_HPP
+#define UNROLL_HPP
+
+#include "optimizer.hpp"
+
+//for (int i = a; i < n; i = i + c): constant trip counts within the budget are unrolled completely,
+//other loops get unrollFactor copies of the body per iteration and a remainder loop
+class LoopUnroller {
+public:
+    explicit LoopUnroller(OptimizerContext&);
+    void run(const shared_ptr<FunctionDefinitionNode>&);
+
+private:
+    //estimated MI instructions of 'i = i + c' plus CMP and conditional jump, and of the 'i + k' in a copy
+    //(ADD into a temporary register and its use)
+    static const int LOOP_CONTROL_COST = 3;
+    static const int OFFSET_COST = 2;
+
+    //counter compared on the left: i op bound
+    struct CountedLoop {
+        string counter;
+        int step;
+        LogicalType compare;
+        shared_ptr<ASTNode> bound;
+    };
+
+    OptimizerContext& context;
+    shared_ptr<FunctionDefinitionNode> function;
+
+    void processBlock(vector<shared_ptr<ASTNode>>&);
+    shared_ptr<ASTNode> unrollLoop(const shared_ptr<ForNode>&);
+    bool analyzeLoop(const shared_ptr<ForNode>&, CountedLoop&);
+    int getTripCount(long long start, long long end, const CountedLoop&, int bodySize);
+    shared_ptr<ASTNode> unrollCompletely(const shared_ptr<ForNode>&, const CountedLoop&, int start, int tripCount);
+    shared_ptr<ASTNode> unrollPartially(const shared_ptr<ForNode>&, const CountedLoop&, int bodySize);
+    static void countCounterUses(const shared_ptr<ASTNode>&, const string& counter, int& uses, int& indexUses);
+    static bool compare(long long a, long long b, LogicalType);
+    static bool containsLoop(const vector<shared_ptr<ASTNode>>&);
+};
+
+#endif //UNROLL_HPP